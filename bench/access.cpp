@@ -0,0 +1,95 @@
+/* Benchmark of checked access to variants.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+
+// Compares get with its error path out of line against the check that get
+// used to make, which built and threw a bad_variant_access where it was
+// inlined, and against try_get and get_if. Every access succeeds, so any
+// difference is in the code around the hot check, which shows more in the
+// size of the callers than in the time.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <juice/variant.hpp>
+
+#include "bench.hpp"
+
+typedef juice::variant<int, long, std::string> Value;
+
+//the check before the error path was moved out of line
+template <size_t I>
+const std::tuple_element_t<I, Value>&
+legacy_get(const Value& v)
+{
+  if (v.index() != I)
+  {
+    throw juice::bad_variant_access("Tuple does not contain requested item");
+  }
+
+  return *juice::get_if<I>(&v);
+}
+
+int main()
+{
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, 1 << 20);
+
+  std::vector<Value> values;
+  for (size_t i = 0; i != 1 << 16; ++i)
+  {
+    values.emplace_back(dist(gen));
+  }
+
+  const size_t mask = values.size() - 1;
+  const size_t iterations = 1 << 24;
+
+  double legacy = bench::time_ns(iterations, [&] (size_t i) {
+    bench::do_not_optimize(legacy_get<0>(values[i & mask]));
+  });
+  bench::report("access/inline throw (previous)", legacy);
+
+  double get = bench::time_ns(iterations, [&] (size_t i) {
+    bench::do_not_optimize(juice::get<0>(values[i & mask]));
+  });
+  bench::report("access/juice::get", get);
+
+  double try_get = bench::time_ns(iterations, [&] (size_t i) {
+    bench::do_not_optimize(juice::try_get<0>(values[i & mask]).value());
+  });
+  bench::report("access/juice::try_get", try_get);
+
+  double get_if = bench::time_ns(iterations, [&] (size_t i) {
+    bench::do_not_optimize(*juice::get_if<0>(&values[i & mask]));
+  });
+  bench::report("access/juice::get_if", get_if);
+
+  return 0;
+}
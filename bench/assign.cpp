@@ -0,0 +1,129 @@
+/* Benchmark of assignment between variants.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Compares copy and move assignment of variants against the visit of the
+// right hand side followed by a copy into a temporary, a second dispatch to
+// destroy the left hand side and a construction that assignment used to be.
+// Run it under perf stat -e instructions to compare instruction counts.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <juice/variant.hpp>
+
+#include "bench.hpp"
+
+typedef juice::variant<int, double, std::string, long> Value;
+
+struct LegacyAssigner
+{
+  Value& lhs;
+  size_t which;
+
+  template <typename T>
+  void
+  operator()(const T& rhs) const
+  {
+    if (lhs.index() == which)
+    {
+      juice::get<T>(lhs) = rhs;
+    }
+    else
+    {
+      T tmp(rhs);
+      lhs.emplace<T>(std::move(tmp));
+    }
+  }
+};
+
+void
+legacy_assign(Value& lhs, const Value& rhs)
+{
+  juice::visit(LegacyAssigner{lhs, rhs.index()}, rhs);
+}
+
+//alternatives picked at random, or all the same when same is set
+std::vector<Value>
+make_values(size_t n, bool same)
+{
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, 3);
+
+  std::vector<Value> values;
+  values.reserve(n);
+  for (size_t i = 0; i != n; ++i)
+  {
+    switch (same ? 1 : dist(gen))
+    {
+      case 0: values.emplace_back(static_cast<int>(i)); break;
+      case 1: values.emplace_back(static_cast<double>(i)); break;
+      case 2: values.emplace_back(std::string("short")); break;
+      default: values.emplace_back(static_cast<long>(i)); break;
+    }
+  }
+
+  return values;
+}
+
+void
+run(const std::string& name, bool same)
+{
+  const auto values = make_values(1 << 12, same);
+  auto targets = values;
+  const size_t mask = values.size() - 1;
+  const size_t iterations = 1 << 22;
+
+  double legacy = bench::time_ns(iterations, [&] (size_t i) {
+    legacy_assign(targets[i & mask], values[(i * 7 + 3) & mask]);
+    bench::do_not_optimize(targets[i & mask]);
+  });
+  bench::report("copy/" + name + "/visit and emplace (previous)", legacy);
+
+  double copy = bench::time_ns(iterations, [&] (size_t i) {
+    targets[i & mask] = values[(i * 7 + 3) & mask];
+    bench::do_not_optimize(targets[i & mask]);
+  });
+  bench::report("copy/" + name + "/operator=", copy);
+
+  auto sources = values;
+  double move = bench::time_ns(iterations, [&] (size_t i) {
+    targets[i & mask] = std::move(sources[(i * 7 + 3) & mask]);
+    bench::do_not_optimize(targets[i & mask]);
+  });
+  bench::report("move/" + name + "/operator=", move);
+}
+
+int main()
+{
+  run("mixed", false);
+  run("same alternative", true);
+
+  return 0;
+}
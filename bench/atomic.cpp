@@ -0,0 +1,229 @@
+/* Benchmark of atomic_variant under contention.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Compares atomic_variant against a variant guarded by a std::mutex, for
+// status cells that are mostly read and for counters that every thread
+// updates with compare_exchange, with 1 to 8 threads. The times are of the
+// whole run divided by the operations of one thread, so they stay flat for
+// as long as the threads don't get in each other's way.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <juice/atomic_variant.hpp>
+
+#include "bench.hpp"
+
+typedef juice::variant<std::uint32_t, float, juice::monostate> Status;
+typedef juice::variant<std::int64_t, double> Wide;
+
+template <typename Variant>
+class locked_variant
+{
+  public:
+  typedef Variant value_type;
+
+  explicit locked_variant(const Variant& v)
+  : m_value(v)
+  {
+  }
+
+  Variant
+  load() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_value;
+  }
+
+  void
+  store(const Variant& v)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_value = v;
+  }
+
+  bool
+  compare_exchange_weak(Variant& expected, const Variant& desired)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_value == expected)
+    {
+      m_value = desired;
+      return true;
+    }
+
+    expected = m_value;
+    return false;
+  }
+
+  private:
+  mutable std::mutex m_mutex;
+  Variant m_value;
+};
+
+template <typename Variant>
+struct atomic_of;
+
+template <typename... Types>
+struct atomic_of<juice::variant<Types...>>
+{
+  typedef juice::atomic_variant<Types...> type;
+};
+
+template <typename Variant>
+using atomic_of_t = typename atomic_of<Variant>::type;
+
+struct ToInt
+{
+  template <typename T>
+  std::int64_t
+  operator()(T t) const
+  {
+    return static_cast<std::int64_t>(t);
+  }
+
+  std::int64_t
+  operator()(juice::monostate) const
+  {
+    return 0;
+  }
+};
+
+//the best of three runs of f on each of threads threads, in nanoseconds
+//per operation of one thread
+template <typename F>
+double
+run_threads(int threads, size_t operations, F f)
+{
+  typedef std::chrono::steady_clock clock;
+
+  double best = 0;
+  for (int r = 0; r != 3; ++r)
+  {
+    std::vector<std::thread> workers;
+    auto start = clock::now();
+    for (int t = 0; t != threads; ++t)
+    {
+      workers.emplace_back([&, t] { f(t, operations); });
+    }
+    for (auto& w : workers)
+    {
+      w.join();
+    }
+    auto end = clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start)
+      .count() / operations;
+    if (r == 0 || ns < best)
+    {
+      best = ns;
+    }
+  }
+
+  return best;
+}
+
+//one store in sixteen, the rest are loads
+template <typename Cell>
+double
+read_mostly(int threads, const typename Cell::value_type& v)
+{
+  Cell cell(v);
+  return run_threads(threads, 1 << 20, [&] (int, size_t n) {
+    std::int64_t sum = 0;
+    for (size_t i = 0; i != n; ++i)
+    {
+      if (i % 16 == 0)
+      {
+        cell.store(v);
+      }
+      else
+      {
+        sum += juice::visit(ToInt(), cell.load());
+      }
+    }
+    bench::do_not_optimize(sum);
+  });
+}
+
+//every operation adds one with compare_exchange
+template <typename Cell>
+double
+increment(int threads, const typename Cell::value_type& v)
+{
+  typedef typename Cell::value_type Variant;
+
+  Cell cell(v);
+  return run_threads(threads, 1 << 18, [&] (int, size_t n) {
+    Variant seen = cell.load();
+    for (size_t i = 0; i != n; ++i)
+    {
+      while (!cell.compare_exchange_weak(seen, Variant(
+        std::tuple_element_t<0, Variant>(juice::visit(ToInt(), seen) + 1))))
+      {
+      }
+    }
+  });
+}
+
+template <typename Variant>
+void
+run(const std::string& name, const Variant& v)
+{
+  for (int threads : {1, 2, 4, 8})
+  {
+    std::string suffix = "/" + std::to_string(threads) + " threads";
+
+    bench::report(name + "/read mostly/mutex" + suffix,
+      read_mostly<locked_variant<Variant>>(threads, v));
+    bench::report(name + "/read mostly/atomic_variant" + suffix,
+      read_mostly<atomic_of_t<Variant>>(threads, v));
+
+    bench::report(name + "/increment/mutex" + suffix,
+      increment<locked_variant<Variant>>(threads, v));
+    bench::report(name + "/increment/atomic_variant" + suffix,
+      increment<atomic_of_t<Variant>>(threads, v));
+  }
+}
+
+int main()
+{
+  std::cout << std::thread::hardware_concurrency() << " hardware threads"
+    << std::endl;
+
+  run("8 bytes", Status(std::uint32_t(1)));
+  run("16 bytes", Wide(std::int64_t(1)));
+
+  return 0;
+}
@@ -0,0 +1,142 @@
+/* Small timing harness for the benchmarks.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef JUICE_BENCH_HPP_INCLUDED
+#define JUICE_BENCH_HPP_INCLUDED
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+  //stops the compiler from optimising away a value
+  template <typename T>
+  inline void
+  do_not_optimize(const T& value)
+  {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  //runs f() in batches of iterations and returns the best time of a batch
+  //in nanoseconds per iteration, the first batch only warms up
+  template <typename F>
+  double
+  time_ns(size_t iterations, F&& f, int repeats = 5)
+  {
+    typedef std::chrono::steady_clock clock;
+
+    for (size_t i = 0; i != iterations; ++i)
+    {
+      f(i);
+    }
+
+    double best = 0;
+    for (int r = 0; r != repeats; ++r)
+    {
+      auto start = clock::now();
+      for (size_t i = 0; i != iterations; ++i)
+      {
+        f(i);
+      }
+      auto end = clock::now();
+
+      double ns = std::chrono::duration<double, std::nano>(end - start)
+        .count() / iterations;
+
+      if (r == 0 || ns < best)
+      {
+        best = ns;
+      }
+    }
+
+    return best;
+  }
+
+  inline void
+  report(const std::string& name, double ns)
+  {
+    std::cout << std::left << std::setw(40) << name
+      << std::right << std::fixed << std::setprecision(3)
+      << std::setw(10) << ns << " ns/op" << std::endl;
+  }
+
+  //collects results to write as a JSON array, one object per result
+  class json_report
+  {
+    public:
+    explicit json_report(std::string build)
+    : m_build(std::move(build))
+    {
+    }
+
+    void
+    add(const std::string& benchmark, const std::string& library,
+      const std::string& distribution, double ns)
+    {
+      m_results.push_back(result{benchmark, library, distribution, ns});
+    }
+
+    void
+    write(std::ostream& out) const
+    {
+      out << "[\n";
+      for (size_t i = 0; i != m_results.size(); ++i)
+      {
+        const result& r = m_results[i];
+        out << "  {\"build\": \"" << m_build
+          << "\", \"benchmark\": \"" << r.benchmark
+          << "\", \"library\": \"" << r.library
+          << "\", \"distribution\": \"" << r.distribution
+          << "\", \"ns_per_op\": " << std::setprecision(3) << std::fixed
+          << r.ns << "}" << (i + 1 == m_results.size() ? "\n" : ",\n");
+      }
+      out << "]\n";
+    }
+
+    private:
+    struct result
+    {
+      std::string benchmark;
+      std::string library;
+      std::string distribution;
+      double ns;
+    };
+
+    std::string m_build;
+    std::vector<result> m_results;
+  };
+}
+
+#endif
@@ -0,0 +1,126 @@
+/* Benchmark of ordering variants.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Compares operator< on variants against the comparison of which() followed
+// by a visit of both variants that it used to be.
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <juice/variant.hpp>
+
+#include "bench.hpp"
+
+typedef juice::variant<int, long, unsigned, double> Key;
+
+struct LegacyLess
+{
+  template <typename T, typename U>
+  bool
+  operator()(const T&, const U&) const
+  {
+    assert(false);
+    return false;
+  }
+
+  template <typename T>
+  bool
+  operator()(const T& a, const T& b) const
+  {
+    return a < b;
+  }
+};
+
+bool
+legacy_less(const Key& v, const Key& w)
+{
+  if (int(v.which()) < int(w.which()))
+  {
+    return true;
+  }
+  else if (v.which() == w.which())
+  {
+    return juice::visit(LegacyLess(), v, w);
+  }
+  else
+  {
+    return false;
+  }
+}
+
+std::vector<Key>
+make_keys(size_t n)
+{
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> alternative(0, 3);
+  std::uniform_int_distribution<int> value(0, 1 << 20);
+
+  std::vector<Key> keys;
+  keys.reserve(n);
+  for (size_t i = 0; i != n; ++i)
+  {
+    int v = value(gen);
+    switch (alternative(gen))
+    {
+      case 0: keys.emplace_back(juice::emplaced_index_t<0>(), v); break;
+      case 1: keys.emplace_back(juice::emplaced_index_t<1>(), v); break;
+      case 2: keys.emplace_back(juice::emplaced_index_t<2>(), v); break;
+      default: keys.emplace_back(juice::emplaced_index_t<3>(), v); break;
+    }
+  }
+
+  return keys;
+}
+
+template <typename Less>
+double
+sort_ns(const std::vector<Key>& keys, Less less)
+{
+  std::vector<Key> copy;
+  return bench::time_ns(1, [&] (size_t) {
+    copy = keys;
+    std::sort(copy.begin(), copy.end(), less);
+    bench::do_not_optimize(copy.front());
+  }) / keys.size();
+}
+
+int main()
+{
+  auto keys = make_keys(1 << 20);
+
+  bench::report("sort/which and visit (previous)", sort_ns(keys,
+    [] (const Key& a, const Key& b) { return legacy_less(a, b); }));
+  bench::report("sort/operator<", sort_ns(keys,
+    [] (const Key& a, const Key& b) { return a < b; }));
+
+  return 0;
+}
@@ -0,0 +1,84 @@
+/* Compile time benchmark of the metafunctions over many types.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Instantiates tuple_find, max and conjunction over ALTERNATIVES types.
+// compile_time.sh times the compilation of this file for several sizes.
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+#include <juice/variant.hpp>
+
+#ifndef ALTERNATIVES
+#define ALTERNATIVES 200
+#endif
+
+template <size_t I>
+struct alternative
+{
+  char data[I % 61 + 1];
+};
+
+template <typename T>
+struct size_of : public std::integral_constant<size_t, sizeof(T)>
+{
+};
+
+template <typename Seq>
+struct types;
+
+template <size_t... I>
+struct types<std::index_sequence<I...>>
+{
+  typedef std::tuple<alternative<I>...> tuple;
+
+  template <size_t K>
+  using find = juice::tuple_find<alternative<K>, tuple>;
+
+  typedef juice::max<size_of, alternative<I>...> largest;
+
+  static constexpr bool all = juice::conjunction<(I >= 0)...>::value;
+};
+
+typedef types<std::make_index_sequence<ALTERNATIVES>> all_types;
+
+static_assert(all_types::find<0>::value == 0, "first");
+static_assert(all_types::find<ALTERNATIVES - 1>::value == ALTERNATIVES - 1,
+  "last");
+static_assert(all_types::find<ALTERNATIVES>::value == juice::tuple_not_found,
+  "missing");
+static_assert(sizeof(all_types::largest::type) ==
+  (ALTERNATIVES < 61 ? ALTERNATIVES : 61), "largest");
+static_assert(all_types::all, "conjunction");
+
+int main()
+{
+  return 0;
+}
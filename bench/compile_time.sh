@@ -0,0 +1,16 @@
+#!/bin/sh
+# Times the compilation of compile_time.cpp with 50, 200 and 1000 types.
+# Run from the top of the repository.
+
+CXX=${CXX:-g++}
+
+for n in 50 200 1000; do
+  start=$(date +%s%N)
+  if $CXX -std=c++14 -fsyntax-only -I. -DALTERNATIVES=$n \
+    bench/compile_time.cpp; then
+    end=$(date +%s%N)
+    echo "compile_time/$n alternatives: $(( (end - start) / 1000000 )) ms"
+  else
+    echo "compile_time/$n alternatives: failed"
+  fi
+done
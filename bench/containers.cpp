@@ -0,0 +1,116 @@
+/* Benchmark of containers of variants.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// A vector of trivially copyable variants is copied and grown with memmove,
+// compared here against a variant of the same size with one alternative that
+// has a user-provided copy constructor.
+
+#include <type_traits>
+#include <vector>
+
+#include <juice/variant.hpp>
+
+#include "bench.hpp"
+
+struct Float
+{
+  Float(float f) : value(f) {}
+  Float(const Float& rhs) : value(rhs.value) {}
+
+  Float&
+  operator=(const Float& rhs)
+  {
+    value = rhs.value;
+    return *this;
+  }
+
+  float value;
+};
+
+typedef juice::variant<int, double, float> Trivial;
+typedef juice::variant<int, double, Float> NonTrivial;
+
+static_assert(sizeof(Trivial) == sizeof(NonTrivial), "sizes differ");
+
+template <typename Variant>
+void
+run(const std::string& name)
+{
+  std::cout << name << " trivially copyable: "
+    << std::is_trivially_copyable<Variant>::value << std::endl;
+
+  const size_t n = 1 << 16;
+  std::vector<Variant> values;
+  for (size_t i = 0; i != n; ++i)
+  {
+    if (i % 3 == 0)
+    {
+      values.emplace_back(juice::emplaced_index_t<0>(), int(i));
+    }
+    else if (i % 3 == 1)
+    {
+      values.emplace_back(juice::emplaced_index_t<1>(), double(i));
+    }
+    else
+    {
+      values.emplace_back(juice::emplaced_index_t<2>(), float(i));
+    }
+  }
+
+  double copy = bench::time_ns(64, [&] (size_t) {
+    std::vector<Variant> copied(values);
+    bench::do_not_optimize(copied.data());
+  });
+  bench::report("containers/" + name + "/copy per element", copy / n);
+
+  double grow = bench::time_ns(64, [&] (size_t) {
+    std::vector<Variant> grown;
+    for (size_t i = 0; i != n; ++i)
+    {
+      grown.push_back(values[i]);
+    }
+    bench::do_not_optimize(grown.data());
+  });
+  bench::report("containers/" + name + "/push_back per element", grow / n);
+}
+
+int main()
+{
+  //the first large allocations of the process are slower, so make them
+  //before timing anything
+  {
+    std::vector<char> warm(1 << 24);
+    bench::do_not_optimize(warm.data());
+  }
+
+  run<Trivial>("trivial");
+  run<NonTrivial>("non-trivial");
+
+  return 0;
+}
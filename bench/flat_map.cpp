@@ -0,0 +1,110 @@
+/* Benchmark of hash maps with variant keys.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Compares lookups in variant_flat_map against std::unordered_map with the
+// same variant keys, and lookups by a bare alternative.
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <juice/variant_flat_map.hpp>
+
+#include "bench.hpp"
+
+typedef juice::variant<std::int64_t, std::string> Key;
+
+int main()
+{
+  const size_t n = 1 << 18;
+
+  std::mt19937_64 gen(42);
+  std::vector<Key> keys;
+  keys.reserve(n);
+  for (size_t i = 0; i != n; ++i)
+  {
+    std::int64_t k = gen();
+    if (i % 4 == 0)
+    {
+      keys.emplace_back(juice::emplaced_index_t<1>(), std::to_string(k));
+    }
+    else
+    {
+      keys.emplace_back(juice::emplaced_index_t<0>(), k);
+    }
+  }
+
+  std::unordered_map<Key, size_t> node_map;
+  juice::variant_flat_map<Key, size_t> flat_map;
+  for (size_t i = 0; i != n; ++i)
+  {
+    node_map[keys[i]] = i;
+    flat_map[keys[i]] = i;
+  }
+
+  //a random order of lookups, so that every one misses the cache
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i != n; ++i)
+  {
+    order[i] = gen() % n;
+  }
+
+  const size_t iterations = 1 << 22;
+  const size_t mask = n - 1;
+
+  double node = bench::time_ns(iterations, [&] (size_t i) {
+    bench::do_not_optimize(node_map.find(keys[order[i & mask]])->second);
+  });
+  bench::report("find/std::unordered_map", node);
+
+  double flat = bench::time_ns(iterations, [&] (size_t i) {
+    bench::do_not_optimize(flat_map.find(keys[order[i & mask]])->second);
+  });
+  bench::report("find/variant_flat_map", flat);
+
+  std::vector<std::int64_t> numbers;
+  for (const Key& k : keys)
+  {
+    if (k.index() == 0)
+    {
+      numbers.push_back(juice::get<0>(k));
+    }
+  }
+  const size_t numbers_mask = (size_t(1) << 17) - 1;
+
+  double bare = bench::time_ns(iterations, [&] (size_t i) {
+    bench::do_not_optimize(flat_map.find(
+      numbers[order[i & mask] & numbers_mask])->second);
+  });
+  bench::report("find/variant_flat_map by alternative", bare);
+
+  return 0;
+}
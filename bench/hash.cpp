@@ -0,0 +1,101 @@
+/* Benchmark of hashing variants.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Compares std::hash of a variant against the hash through typeid that it
+// used to be, and against hash_batch over the whole range.
+
+#include <functional>
+#include <random>
+#include <typeindex>
+#include <vector>
+
+#include <juice/variant.hpp>
+
+#include "bench.hpp"
+
+typedef juice::variant<int, long, unsigned, double> Key;
+
+size_t
+legacy_combine(size_t seed, size_t combine)
+{
+  return seed ^ (combine + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+struct LegacyHash
+{
+  template <typename T>
+  size_t
+  operator()(const T& t) const
+  {
+    size_t h = std::hash<std::type_index>()(std::type_index(typeid(t)));
+    return legacy_combine(h, std::hash<T>()(t));
+  }
+};
+
+int main()
+{
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, 3);
+
+  std::vector<Key> keys;
+  for (int i = 0; i != 1 << 16; ++i)
+  {
+    switch (dist(gen))
+    {
+      case 0: keys.emplace_back(juice::emplaced_index_t<0>(), i); break;
+      case 1: keys.emplace_back(juice::emplaced_index_t<1>(), i); break;
+      case 2: keys.emplace_back(juice::emplaced_index_t<2>(), i); break;
+      default: keys.emplace_back(juice::emplaced_index_t<3>(), i); break;
+    }
+  }
+
+  const size_t mask = keys.size() - 1;
+  const size_t iterations = 1 << 24;
+
+  double legacy = bench::time_ns(iterations, [&] (size_t i) {
+    bench::do_not_optimize(juice::visit(LegacyHash(), keys[i & mask]));
+  });
+  bench::report("hash/typeid (previous)", legacy);
+
+  std::hash<Key> hash;
+  double current = bench::time_ns(iterations, [&] (size_t i) {
+    bench::do_not_optimize(hash(keys[i & mask]));
+  });
+  bench::report("hash/std::hash", current);
+
+  std::vector<size_t> hashes(keys.size());
+  double batch = bench::time_ns(64, [&] (size_t) {
+    juice::hash_batch(keys.data(), keys.data() + keys.size(),
+      hashes.data());
+    bench::do_not_optimize(hashes.front());
+  }) / keys.size();
+  bench::report("hash/hash_batch", batch);
+
+  return 0;
+}
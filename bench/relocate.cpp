@@ -0,0 +1,116 @@
+/* Benchmark of relocating and swapping variants.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Compares swapping variants with three moves against variant::swap, which
+// swaps their bytes when every alternative is trivially relocatable, and
+// growing a buffer of variants by moving and destroying each one against
+// relocate.
+
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <juice/variant.hpp>
+
+#include "bench.hpp"
+
+typedef juice::variant<int, double, std::unique_ptr<int>,
+  std::shared_ptr<int>> Value;
+
+static_assert(juice::is_trivially_relocatable<Value>::value,
+  "Value is not trivially relocatable");
+
+std::vector<Value>
+make_values(size_t n)
+{
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, 3);
+
+  std::vector<Value> values;
+  values.reserve(n);
+  for (size_t i = 0; i != n; ++i)
+  {
+    switch (dist(gen))
+    {
+      case 0: values.emplace_back(static_cast<int>(i)); break;
+      case 1: values.emplace_back(static_cast<double>(i)); break;
+      case 2: values.emplace_back(std::make_unique<int>(i)); break;
+      default: values.emplace_back(std::make_shared<int>(i)); break;
+    }
+  }
+
+  return values;
+}
+
+void
+move_and_destroy(Value* first, Value* last, Value* out)
+{
+  for (; first != last; ++first, ++out)
+  {
+    ::new (static_cast<void*>(out)) Value(std::move(*first));
+    first->~Value();
+  }
+}
+
+int main()
+{
+  auto values = make_values(1 << 16);
+  const size_t mask = values.size() - 1;
+  const size_t iterations = 1 << 22;
+
+  double moves = bench::time_ns(iterations, [&] (size_t i) {
+    std::swap(values[i & mask], values[(i * 7919) & mask]);
+  });
+  bench::report("swap/std::swap, three moves", moves);
+
+  double swaps = bench::time_ns(iterations, [&] (size_t i) {
+    values[i & mask].swap(values[(i * 7919) & mask]);
+  });
+  bench::report("swap/variant::swap", swaps);
+
+  //each batch moves the values to the other buffer and back
+  const size_t n = values.size();
+  std::unique_ptr<unsigned char[]> buffer(new unsigned char[n * sizeof(Value)]);
+  Value* other = reinterpret_cast<Value*>(buffer.get());
+
+  double moved = bench::time_ns(16, [&] (size_t) {
+    move_and_destroy(values.data(), values.data() + n, other);
+    move_and_destroy(other, other + n, values.data());
+  }) / (2 * n);
+  bench::report("grow/move and destroy", moved);
+
+  double relocated = bench::time_ns(16, [&] (size_t) {
+    juice::relocate(values.data(), values.data() + n, other);
+    juice::relocate(other, other + n, values.data());
+  }) / (2 * n);
+  bench::report("grow/relocate", relocated);
+
+  return 0;
+}
@@ -0,0 +1,178 @@
+/* Benchmark of seqlock_variant as readers are added.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Compares seqlock_variant against a variant guarded by a
+// std::shared_timed_mutex, with 1 to 16 readers loading a 40 byte variant
+// while one writer stores a new value every few microseconds. The time is
+// of the whole run divided by the loads of one reader, so it stays flat for
+// as long as readers don't slow each other down.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <juice/seqlock_variant.hpp>
+
+#include "bench.hpp"
+
+struct Quote
+{
+  double bid;
+  double ask;
+  std::int64_t time;
+  std::int64_t volume;
+};
+
+typedef juice::variant<Quote, std::int64_t, juice::monostate> Value;
+
+class locked_variant
+{
+  public:
+  explicit locked_variant(const Value& v)
+  : m_value(v)
+  {
+  }
+
+  Value
+  load() const
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(m_mutex);
+    return m_value;
+  }
+
+  void
+  store(const Value& v)
+  {
+    std::lock_guard<std::shared_timed_mutex> lock(m_mutex);
+    m_value = v;
+  }
+
+  private:
+  mutable std::shared_timed_mutex m_mutex;
+  Value m_value;
+};
+
+struct Sum
+{
+  double
+  operator()(const Quote& q) const
+  {
+    return q.bid + q.ask;
+  }
+
+  double
+  operator()(std::int64_t i) const
+  {
+    return static_cast<double>(i);
+  }
+
+  double
+  operator()(juice::monostate) const
+  {
+    return 0;
+  }
+};
+
+//the best of three runs, in nanoseconds per load of one reader
+template <typename Cell>
+double
+run(int readers)
+{
+  typedef std::chrono::steady_clock clock;
+  const size_t loads = 1 << 20;
+
+  double best = 0;
+  for (int r = 0; r != 3; ++r)
+  {
+    Cell cell(Value(Quote{1, 2, 0, 0}));
+    std::atomic<bool> done(false);
+
+    std::thread writer([&] {
+      for (std::int64_t i = 0; !done.load(std::memory_order_relaxed); ++i)
+      {
+        cell.store(Value(Quote{1, 2, i, i}));
+        std::this_thread::sleep_for(std::chrono::microseconds(5));
+      }
+    });
+
+    std::vector<std::thread> workers;
+    auto start = clock::now();
+    for (int t = 0; t != readers; ++t)
+    {
+      workers.emplace_back([&] {
+        double sum = 0;
+        for (size_t i = 0; i != loads; ++i)
+        {
+          sum += juice::visit(Sum(), cell.load());
+        }
+        bench::do_not_optimize(sum);
+      });
+    }
+    for (auto& w : workers)
+    {
+      w.join();
+    }
+    auto end = clock::now();
+
+    done = true;
+    writer.join();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start)
+      .count() / loads;
+    if (r == 0 || ns < best)
+    {
+      best = ns;
+    }
+  }
+
+  return best;
+}
+
+int main()
+{
+  std::cout << std::thread::hardware_concurrency() << " hardware threads"
+    << std::endl;
+
+  for (int readers : {1, 2, 4, 8, 16})
+  {
+    std::string suffix = "/" + std::to_string(readers) + " readers";
+    bench::report("load/shared_timed_mutex" + suffix,
+      run<locked_variant>(readers));
+    bench::report("load/seqlock_variant" + suffix,
+      run<juice::seqlock_variant<Quote, std::int64_t, juice::monostate>>(
+        readers));
+  }
+
+  return 0;
+}
@@ -0,0 +1,354 @@
+/* Benchmark suite comparing juice::variant with std::variant.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Measures visit, multi-visit, get and get_if, comparison and hashing on a
+// variant of eight arithmetic types, and copy, move and assignment on a
+// variant holding a std::string, for juice::variant and std::variant. The
+// alternatives are drawn uniformly, skewed with nine in ten the first
+// alternative, or uniformly and then sorted. This needs C++17 for
+// std::variant, and is built at both -O2 and -O3.
+//
+// Prints a table, and writes the results as JSON to the file named by the
+// first argument if there is one.
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <juice/variant.hpp>
+
+#include "bench.hpp"
+
+#ifndef BENCH_BUILD
+#define BENCH_BUILD "unknown"
+#endif
+
+struct JuiceVariant
+{
+  static constexpr const char* name = "juice";
+
+  template <typename... Types>
+  using variant = juice::variant<Types...>;
+
+  template <typename V>
+  static constexpr size_t size = std::tuple_size<V>::value;
+
+  template <size_t I, typename V>
+  using alternative_t = std::tuple_element_t<I, V>;
+
+  template <size_t I, typename V, typename T>
+  static V
+  make(T&& t)
+  {
+    return V(juice::emplaced_index_t<I>(), std::forward<T>(t));
+  }
+
+  template <typename... Args>
+  static decltype(auto)
+  visit(Args&&... args)
+  {
+    return juice::visit(std::forward<Args>(args)...);
+  }
+
+  template <size_t I, typename V>
+  static auto
+  get_if(const V* v)
+  {
+    return juice::get_if<I>(v);
+  }
+
+  template <size_t I, typename V>
+  static decltype(auto)
+  get(const V& v)
+  {
+    return juice::get<I>(v);
+  }
+};
+
+struct StdVariant
+{
+  static constexpr const char* name = "std";
+
+  template <typename... Types>
+  using variant = std::variant<Types...>;
+
+  template <typename V>
+  static constexpr size_t size = std::variant_size<V>::value;
+
+  template <size_t I, typename V>
+  using alternative_t = std::variant_alternative_t<I, V>;
+
+  template <size_t I, typename V, typename T>
+  static V
+  make(T&& t)
+  {
+    return V(std::in_place_index<I>, std::forward<T>(t));
+  }
+
+  template <typename... Args>
+  static decltype(auto)
+  visit(Args&&... args)
+  {
+    return std::visit(std::forward<Args>(args)...);
+  }
+
+  template <size_t I, typename V>
+  static auto
+  get_if(const V* v)
+  {
+    return std::get_if<I>(v);
+  }
+
+  template <size_t I, typename V>
+  static decltype(auto)
+  get(const V& v)
+  {
+    return std::get<I>(v);
+  }
+};
+
+template <typename Lib>
+using Arithmetic = typename Lib::template variant<int, long, short, unsigned,
+  char, double, float, unsigned char>;
+
+template <typename Lib>
+using Text = typename Lib::template variant<int, double, std::string>;
+
+const size_t elements = 1 << 16;
+const size_t mask = elements - 1;
+const size_t iterations = 1 << 22;
+
+template <typename T>
+T
+value_for(size_t i)
+{
+  return static_cast<T>(i % 100 + 1);
+}
+
+//long enough not to fit in the small string buffer
+template <>
+std::string
+value_for<std::string>(size_t i)
+{
+  return std::string(24, static_cast<char>('a' + i % 26));
+}
+
+template <typename Lib, typename V, size_t... I>
+V
+make_variant(size_t which, size_t i, std::index_sequence<I...>)
+{
+  typedef V (*maker)(size_t);
+  static const maker makers[] = {
+    [] (size_t k) {
+      return Lib::template make<I, V>(
+        value_for<typename Lib::template alternative_t<I, V>>(k));
+    }...
+  };
+  return makers[which](i);
+}
+
+std::vector<size_t>
+draw(const std::string& distribution, size_t alternatives, unsigned seed)
+{
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<size_t> uniform(0, alternatives - 1);
+  std::uniform_int_distribution<size_t> rest(1, alternatives - 1);
+  std::uniform_int_distribution<int> percent(0, 99);
+
+  std::vector<size_t> indices(elements);
+  for (size_t& index : indices)
+  {
+    if (distribution == "skewed")
+    {
+      index = percent(gen) < 90 ? 0 : rest(gen);
+    }
+    else
+    {
+      index = uniform(gen);
+    }
+  }
+
+  if (distribution == "sorted")
+  {
+    std::sort(indices.begin(), indices.end());
+  }
+
+  return indices;
+}
+
+template <typename Lib, typename V>
+std::vector<V>
+make_values(const std::string& distribution, unsigned seed)
+{
+  constexpr size_t N = Lib::template size<V>;
+
+  auto indices = draw(distribution, N, seed);
+  std::vector<V> values;
+  values.reserve(elements);
+  for (size_t i = 0; i != elements; ++i)
+  {
+    values.push_back(make_variant<Lib, V>(indices[i], i,
+      std::make_index_sequence<N>()));
+  }
+  return values;
+}
+
+struct Sum
+{
+  template <typename T>
+  long
+  operator()(T t) const
+  {
+    return static_cast<long>(t) + 1;
+  }
+
+  template <typename T, typename U>
+  long
+  operator()(T t, U u) const
+  {
+    return static_cast<long>(t) * 3 + static_cast<long>(u);
+  }
+};
+
+class Suite
+{
+  public:
+  explicit Suite(bench::json_report& json)
+  : m_json(json)
+  {
+  }
+
+  template <typename F>
+  void
+  run(const std::string& benchmark, const std::string& library,
+    const std::string& distribution, F&& f)
+  {
+    double ns = bench::time_ns(iterations, f, 3);
+    bench::report(benchmark + "/" + distribution + "/" + library, ns);
+    m_json.add(benchmark, library, distribution, ns);
+  }
+
+  private:
+  bench::json_report& m_json;
+};
+
+template <typename Lib>
+void
+arithmetic(Suite& suite, const std::string& distribution)
+{
+  typedef Arithmetic<Lib> V;
+  const auto a = make_values<Lib, V>(distribution, 42);
+  const auto b = make_values<Lib, V>(distribution, 43);
+
+  suite.run("visit", Lib::name, distribution, [&] (size_t i) {
+    bench::do_not_optimize(Lib::visit(Sum(), a[i & mask]));
+  });
+
+  suite.run("multi_visit", Lib::name, distribution, [&] (size_t i) {
+    bench::do_not_optimize(Lib::visit(Sum(), a[i & mask], b[i & mask]));
+  });
+
+  suite.run("get_if", Lib::name, distribution, [&] (size_t i) {
+    auto p = Lib::template get_if<0>(&a[i & mask]);
+    bench::do_not_optimize(p ? *p : -1);
+  });
+
+  suite.run("get", Lib::name, distribution, [&] (size_t i) {
+    const V& v = a[i & mask];
+    bench::do_not_optimize(v.index() == 5 ? Lib::template get<5>(v) : 0.0);
+  });
+
+  suite.run("less", Lib::name, distribution, [&] (size_t i) {
+    bench::do_not_optimize(a[i & mask] < b[i & mask]);
+  });
+
+  suite.run("equal", Lib::name, distribution, [&] (size_t i) {
+    bench::do_not_optimize(a[i & mask] == b[i & mask]);
+  });
+
+  std::hash<V> hash;
+  suite.run("hash", Lib::name, distribution, [&] (size_t i) {
+    bench::do_not_optimize(hash(a[i & mask]));
+  });
+}
+
+template <typename Lib>
+void
+text(Suite& suite, const std::string& distribution)
+{
+  typedef Text<Lib> V;
+  const auto a = make_values<Lib, V>(distribution, 42);
+  const auto b = make_values<Lib, V>(distribution, 43);
+
+  suite.run("copy", Lib::name, distribution, [&] (size_t i) {
+    V copy(a[i & mask]);
+    bench::do_not_optimize(copy);
+  });
+
+  auto moving = a;
+  suite.run("move", Lib::name, distribution, [&] (size_t i) {
+    V moved(std::move(moving[i & mask]));
+    moving[i & mask] = std::move(moved);
+  });
+
+  //every pass over the elements assigns from the other source, so that
+  //the alternatives change as often as the distribution makes them
+  auto target = b;
+  const std::vector<V>* sources[] = {&a, &b};
+  suite.run("copy_assign", Lib::name, distribution, [&] (size_t i) {
+    target[i & mask] = (*sources[(i / elements) & 1])[i & mask];
+  });
+  bench::do_not_optimize(target.front());
+}
+
+int main(int argc, char** argv)
+{
+  bench::json_report json(BENCH_BUILD);
+  Suite suite(json);
+
+  for (const char* distribution : {"uniform", "skewed", "sorted"})
+  {
+    arithmetic<JuiceVariant>(suite, distribution);
+    arithmetic<StdVariant>(suite, distribution);
+    text<JuiceVariant>(suite, distribution);
+    text<StdVariant>(suite, distribution);
+  }
+
+  if (argc > 1)
+  {
+    std::ofstream out(argv[1]);
+    json.write(out);
+  }
+
+  return 0;
+}
@@ -0,0 +1,140 @@
+/* Benchmark of the destruction of recursive variant trees.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Destroys deep and wide trees of recursive_wrapper nodes. The wide tree is
+// compared against the same tree built from std::unique_ptr, which is
+// destroyed by recursion.
+
+#include <chrono>
+#include <memory>
+
+#include <juice/variant.hpp>
+
+#include "bench.hpp"
+
+struct Cons;
+struct Branch;
+
+typedef juice::variant<juice::monostate, juice::recursive_wrapper<Cons>> List;
+typedef juice::variant<int, juice::recursive_wrapper<Branch>> Tree;
+
+struct Cons
+{
+  int head;
+  List tail;
+};
+
+struct Branch
+{
+  Tree left;
+  Tree right;
+};
+
+struct PointerTree
+{
+  std::unique_ptr<PointerTree> left;
+  std::unique_ptr<PointerTree> right;
+};
+
+List
+make_list(int length)
+{
+  List list;
+  for (int i = 0; i != length; ++i)
+  {
+    List next(Cons{i, std::move(list)});
+    list = std::move(next);
+  }
+  return list;
+}
+
+Tree
+make_tree(int depth)
+{
+  if (depth == 0)
+  {
+    return Tree(depth);
+  }
+  return Tree(Branch{make_tree(depth - 1), make_tree(depth - 1)});
+}
+
+std::unique_ptr<PointerTree>
+make_pointer_tree(int depth)
+{
+  std::unique_ptr<PointerTree> t(new PointerTree);
+  if (depth != 0)
+  {
+    t->left = make_pointer_tree(depth - 1);
+    t->right = make_pointer_tree(depth - 1);
+  }
+  return t;
+}
+
+//the best time to destroy what make() returns, in ns per node
+template <typename Make>
+double
+destroy_ns(size_t nodes, Make&& make, int repeats = 5)
+{
+  typedef std::chrono::steady_clock clock;
+
+  double best = 0;
+  for (int r = 0; r != repeats; ++r)
+  {
+    auto value = make();
+    auto start = clock::now();
+    {
+      auto dead = std::move(value);
+    }
+    auto end = clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start)
+      .count() / nodes;
+    if (r == 0 || ns < best)
+    {
+      best = ns;
+    }
+  }
+  return best;
+}
+
+int main()
+{
+  const int length = 1 << 20;
+  bench::report("teardown/deep list/recursive_wrapper",
+    destroy_ns(length, [] { return make_list(length); }));
+
+  const int depth = 20;
+  const size_t nodes = (size_t(2) << depth) - 1;
+  bench::report("teardown/wide tree/recursive_wrapper",
+    destroy_ns(nodes, [] { return make_tree(depth); }));
+  bench::report("teardown/wide tree/unique_ptr",
+    destroy_ns(nodes, [] { return make_pointer_tree(depth); }));
+
+  return 0;
+}
@@ -0,0 +1,153 @@
+/* Benchmark of variant visitation dispatch.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Compares juice::visit against the function-local static table of function
+// pointers that visit used to dispatch through, against visit_likely with the
+// int alternative as the hint, and against visit_batch over the whole range.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <juice/variant.hpp>
+#include <juice/visit_batch.hpp>
+
+#include "bench.hpp"
+
+typedef juice::variant<int, long, short, unsigned, char, double, float,
+  unsigned char> Small;
+
+struct Sum
+{
+  template <typename T>
+  long
+  operator()(T t) const
+  {
+    return static_cast<long>(t) + 1;
+  }
+};
+
+template <size_t I, typename Visitor, typename Variant>
+long
+legacy_caller(Visitor& visitor, const Variant& v)
+{
+  return visitor(juice::get<I>(v));
+}
+
+template <typename Visitor, typename Variant, size_t... I>
+long
+legacy_visit(Visitor& visitor, const Variant& v, std::index_sequence<I...>)
+{
+  typedef long (*caller)(Visitor&, const Variant&);
+
+  static caller callers[sizeof...(I)] =
+  {
+    &legacy_caller<I, Visitor, Variant>...
+  };
+
+  return callers[v.index()](visitor, v);
+}
+
+template <typename Variant>
+std::vector<Variant>
+make_values(size_t n, int spread = 7)
+{
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, spread);
+
+  std::vector<Variant> values;
+  values.reserve(n);
+  for (size_t i = 0; i != n; ++i)
+  {
+    //values past the last alternative make up the int skew
+    switch (dist(gen))
+    {
+      case 0: values.emplace_back(juice::emplaced_index_t<0>(), 1); break;
+      case 1: values.emplace_back(juice::emplaced_index_t<1>(), 2); break;
+      case 2: values.emplace_back(juice::emplaced_index_t<2>(), 3); break;
+      case 3: values.emplace_back(juice::emplaced_index_t<3>(), 4); break;
+      case 4: values.emplace_back(juice::emplaced_index_t<4>(), 5); break;
+      case 5: values.emplace_back(juice::emplaced_index_t<5>(), 6); break;
+      case 6: values.emplace_back(juice::emplaced_index_t<6>(), 7); break;
+      case 7: values.emplace_back(juice::emplaced_index_t<7>(), 8); break;
+      default: values.emplace_back(juice::emplaced_index_t<0>(), 1); break;
+    }
+  }
+
+  return values;
+}
+
+template <typename Variant>
+void
+run(const std::string& name, const std::vector<Variant>& values)
+{
+  const size_t mask = values.size() - 1;
+  const size_t iterations = 1 << 24;
+
+  Sum sum;
+
+  double legacy = bench::time_ns(iterations, [&] (size_t i) {
+    bench::do_not_optimize(legacy_visit(sum, values[i & mask],
+      std::make_index_sequence<8>()));
+  });
+  bench::report("visit/" + name + "/static table (previous)", legacy);
+
+  double current = bench::time_ns(iterations, [&] (size_t i) {
+    bench::do_not_optimize(juice::visit(sum, values[i & mask]));
+  });
+  bench::report("visit/" + name + "/juice::visit", current);
+
+  double likely = bench::time_ns(iterations, [&] (size_t i) {
+    bench::do_not_optimize(juice::visit_likely<int>(sum, values[i & mask]));
+  });
+  bench::report("visit/" + name + "/juice::visit_likely<int>", likely);
+
+  long total = 0;
+  double batch = bench::time_ns(64, [&] (size_t) {
+    juice::visit_batch([&] (auto t) { total += sum(t); },
+      values.begin(), values.end());
+  }) / values.size();
+  bench::do_not_optimize(total);
+  bench::report("visit/" + name + "/juice::visit_batch", batch);
+}
+
+int main()
+{
+  auto values = make_values<Small>(1 << 16);
+  run("uniform", values);
+
+  //seven in eight are int
+  run("skewed", make_values<Small>(1 << 16, 63));
+
+  std::stable_sort(values.begin(), values.end(),
+    [] (const Small& a, const Small& b) { return a.index() < b.index(); });
+  run("sorted", values);
+
+  return 0;
+}
@@ -0,0 +1,402 @@
+/* A variant of small trivially copyable types that is updated atomically.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// atomic_variant<Types...> holds a variant<Types...> in one 8 or 16 byte
+// word, the bytes of the value followed by a byte for its index, and loads,
+// stores, exchanges and compares it without a lock. Every alternative must
+// be trivially copyable, and the largest one must leave a byte for the
+// index in 16 bytes, or it doesn't compile.
+//
+// An 8 byte word is a std::atomic<std::uint64_t>. A 16 byte word is updated
+// with cmpxchg16b through the __sync builtins, which needs -mcx16 on x86-64
+// and is always sequentially consistent, whatever order is asked for.
+//
+// compare_exchange compares the bytes of the values, so like std::atomic it
+// doesn't see padding inside an alternative as equal, and it tells 0.0 from
+// -0.0. Empty alternatives, such as monostate, are stored as zero bytes.
+
+#ifndef JUICE_ATOMIC_VARIANT_HPP_INCLUDED
+#define JUICE_ATOMIC_VARIANT_HPP_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "variant.hpp"
+
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define JUICE_ATOMIC_VARIANT_WIDE 1
+#else
+#define JUICE_ATOMIC_VARIANT_WIDE 0
+#endif
+
+namespace juice
+{
+  namespace detail
+  {
+    template <typename... Types>
+    constexpr size_t
+    atomic_payload_size()
+    {
+      size_t sizes[] = {sizeof(Types)...};
+      size_t size = 0;
+      for (size_t s : sizes)
+      {
+        size = s > size ? s : size;
+      }
+      return size;
+    }
+
+    template <size_t Size>
+    class atomic_word;
+
+    template <>
+    class atomic_word<8>
+    {
+      public:
+      typedef std::uint64_t type;
+
+      static constexpr bool lock_free = ATOMIC_LLONG_LOCK_FREE == 2;
+
+      explicit atomic_word(type w)
+      : m_cell(w)
+      {
+      }
+
+      type
+      load(std::memory_order order) const
+      {
+        return m_cell.load(order);
+      }
+
+      void
+      store(type w, std::memory_order order)
+      {
+        m_cell.store(w, order);
+      }
+
+      type
+      exchange(type w, std::memory_order order)
+      {
+        return m_cell.exchange(w, order);
+      }
+
+      bool
+      compare_exchange_weak(type& expected, type desired,
+        std::memory_order success, std::memory_order failure)
+      {
+        return m_cell.compare_exchange_weak(expected, desired, success,
+          failure);
+      }
+
+      bool
+      compare_exchange_strong(type& expected, type desired,
+        std::memory_order success, std::memory_order failure)
+      {
+        return m_cell.compare_exchange_strong(expected, desired, success,
+          failure);
+      }
+
+      private:
+      std::atomic<type> m_cell;
+    };
+
+#if JUICE_ATOMIC_VARIANT_WIDE
+    //std::atomic of 16 bytes calls into libatomic, so this uses cmpxchg16b
+    //directly, a load is a compare and swap that can't change the word
+    template <>
+    class atomic_word<16>
+    {
+      public:
+      typedef unsigned __int128 type;
+
+      static constexpr bool lock_free = true;
+
+      explicit atomic_word(type w)
+      : m_cell(w)
+      {
+      }
+
+      type
+      load(std::memory_order) const
+      {
+        return __sync_val_compare_and_swap(&m_cell, 0, 0);
+      }
+
+      void
+      store(type w, std::memory_order order)
+      {
+        exchange(w, order);
+      }
+
+      type
+      exchange(type w, std::memory_order order)
+      {
+        type expected = load(order);
+        while (!compare_exchange_strong(expected, w, order, order))
+        {
+        }
+        return expected;
+      }
+
+      bool
+      compare_exchange_weak(type& expected, type desired,
+        std::memory_order success, std::memory_order failure)
+      {
+        return compare_exchange_strong(expected, desired, success, failure);
+      }
+
+      bool
+      compare_exchange_strong(type& expected, type desired,
+        std::memory_order, std::memory_order)
+      {
+        type seen = __sync_val_compare_and_swap(&m_cell, expected, desired);
+        if (seen == expected)
+        {
+          return true;
+        }
+
+        expected = seen;
+        return false;
+      }
+
+      private:
+      alignas(16) mutable type m_cell;
+    };
+#endif
+
+    //copies the bytes of the I'th alternative to the front of a word
+    struct atomic_encoder
+    {
+      template <size_t I, typename Variant>
+      static void
+      call(unsigned char* bytes, const Variant& v)
+      {
+        typedef std::tuple_element_t<I, Variant> T;
+        copy_bytes(bytes, variant_access::get<I>(v), std::is_empty<T>());
+      }
+
+      template <typename T>
+      static void
+      copy_bytes(unsigned char* bytes, const T& t, std::false_type)
+      {
+        std::memcpy(bytes, &t, sizeof(T));
+      }
+
+      template <typename T>
+      static void
+      copy_bytes(unsigned char*, const T&, std::true_type)
+      {
+      }
+    };
+
+    //makes a variant of the I'th alternative from the front of a word
+    template <typename Variant>
+    struct atomic_decoder
+    {
+      template <size_t I>
+      static Variant
+      call(const unsigned char* bytes)
+      {
+        typedef std::tuple_element_t<I, Variant> T;
+
+        std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+        std::memcpy(&storage, bytes, sizeof(T));
+        return Variant(emplaced_index_t<I>(),
+          *reinterpret_cast<const T*>(&storage));
+      }
+    };
+  }
+
+  template <typename... Types>
+  class atomic_variant
+  {
+    public:
+    typedef variant<Types...> value_type;
+
+    private:
+    static constexpr size_t payload_size =
+      detail::atomic_payload_size<Types...>();
+
+    static_assert(conjunction<
+        std::is_trivially_copyable<Types>::value...
+      >::value, "atomic_variant needs trivially copyable alternatives");
+    static_assert(sizeof...(Types) <= 256,
+      "atomic_variant stores the index in one byte");
+    static_assert(payload_size < 16,
+      "atomic_variant packs the value and its index into 16 bytes at most");
+    static_assert(payload_size < 8 || JUICE_ATOMIC_VARIANT_WIDE,
+      "atomic_variant of more than 8 bytes needs cmpxchg16b, build with "
+      "-mcx16");
+
+    typedef detail::atomic_word<(payload_size < 8 ? 8 : 16)> word_type;
+    typedef typename word_type::type word;
+
+    public:
+    static constexpr size_t size = sizeof(word);
+    static constexpr bool is_always_lock_free = word_type::lock_free;
+
+    atomic_variant()
+    : m_word(encode(value_type()))
+    {
+    }
+
+    atomic_variant(const value_type& v)
+    : m_word(encode(v))
+    {
+    }
+
+    atomic_variant(const atomic_variant&) = delete;
+
+    atomic_variant&
+    operator=(const atomic_variant&) = delete;
+
+    atomic_variant&
+    operator=(const value_type& v)
+    {
+      store(v);
+      return *this;
+    }
+
+    operator value_type() const
+    {
+      return load();
+    }
+
+    bool
+    is_lock_free() const
+    {
+      return is_always_lock_free;
+    }
+
+    value_type
+    load(std::memory_order order = std::memory_order_seq_cst) const
+    {
+      return decode(m_word.load(order));
+    }
+
+    void
+    store(const value_type& v,
+      std::memory_order order = std::memory_order_seq_cst)
+    {
+      m_word.store(encode(v), order);
+    }
+
+    value_type
+    exchange(const value_type& v,
+      std::memory_order order = std::memory_order_seq_cst)
+    {
+      return decode(m_word.exchange(encode(v), order));
+    }
+
+    //Replaces the value with desired if it is expected, and otherwise
+    //loads the value into expected.
+    bool
+    compare_exchange_weak(value_type& expected, const value_type& desired,
+      std::memory_order order = std::memory_order_seq_cst)
+    {
+      word w = encode(expected);
+      if (m_word.compare_exchange_weak(w, encode(desired), order,
+        failure_order(order)))
+      {
+        return true;
+      }
+
+      expected = decode(w);
+      return false;
+    }
+
+    bool
+    compare_exchange_strong(value_type& expected, const value_type& desired,
+      std::memory_order order = std::memory_order_seq_cst)
+    {
+      word w = encode(expected);
+      if (m_word.compare_exchange_strong(w, encode(desired), order,
+        failure_order(order)))
+      {
+        return true;
+      }
+
+      expected = decode(w);
+      return false;
+    }
+
+    private:
+    word_type m_word;
+
+    //a valueless variant can't be stored, as it has no bytes to store
+    static word
+    encode(const value_type& v)
+    {
+      if (v.valueless_by_exception())
+      {
+        detail::raise<bad_variant_access>("atomic_variant can't hold a "
+          "valueless variant");
+      }
+
+      unsigned char bytes[sizeof(word)] = {};
+      detail::dispatcher
+      <
+        void,
+        sizeof...(Types),
+        detail::atomic_encoder
+      >::dispatch(v.index(), bytes, v);
+      bytes[payload_size] = static_cast<unsigned char>(v.index());
+
+      word w;
+      std::memcpy(&w, bytes, sizeof(word));
+      return w;
+    }
+
+    static value_type
+    decode(word w)
+    {
+      unsigned char bytes[sizeof(word)];
+      std::memcpy(bytes, &w, sizeof(word));
+
+      return detail::dispatcher
+      <
+        value_type,
+        sizeof...(Types),
+        detail::atomic_decoder<value_type>
+      >::dispatch(bytes[payload_size], bytes);
+    }
+
+    static constexpr std::memory_order
+    failure_order(std::memory_order order)
+    {
+      return order == std::memory_order_acq_rel ? std::memory_order_acquire
+        : order == std::memory_order_release ? std::memory_order_relaxed
+        : order;
+    }
+  };
+}
+
+#endif
@@ -1,23 +1,21 @@
+#include <type_traits>
+
 namespace juice
 {
-  template <bool... B>
-  struct conjunction;
-
-  template <bool... B>
-  struct conjunction <false, B...>
+  namespace detail
   {
-    static constexpr bool value = false;
-  };
+    template <bool... B>
+    struct bool_pack;
+  }
 
+  //true if every B is true, found by comparing the pack with itself
+  //shifted by one rather than by recursion
   template <bool... B>
-  struct conjunction<true, B...>
-  {
-    static constexpr bool value = conjunction<B...>::value;
-  };
-
-  template <>
-  struct conjunction<>
+  struct conjunction
   {
-    static constexpr bool value = true;
+    static constexpr bool value = std::is_same<
+      detail::bool_pack<true, B...>,
+      detail::bool_pack<B..., true>
+    >::value;
   };
 }
@@ -0,0 +1,376 @@
+/* A flattened representation of trees of recursive variants.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// A tree of recursive variants keeps every recursive_wrapper node in its own
+// heap allocation. flat_tree copies such a tree into one array of nodes in
+// breadth first order, where the children of a node are the consecutive
+// nodes starting at an index stored in the node. Walking every node is then
+// a scan of the array.
+//
+// A node of the flat tree holds a payload instead of the alternative. It is
+// the alternative itself, or for a recursive_wrapper<T> the data of the T
+// without its children, which tree_children<T> describes.
+//
+// visit_node and for_each_child work on both a variant and a flat_node, so
+// that an algorithm written with them runs on either form.
+
+#ifndef JUICE_FLAT_TREE_HPP_INCLUDED
+#define JUICE_FLAT_TREE_HPP_INCLUDED
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "variant.hpp"
+
+namespace juice
+{
+  //Describes the children of a T that is held in a recursive_wrapper. It
+  //must be specialised for each such T, for example
+  //  template <>
+  //  struct tree_children<Binary>
+  //  {
+  //    typedef char payload_type;
+  //
+  //    static payload_type
+  //    payload(const Binary& b) { return b.op; }
+  //
+  //    template <typename F>
+  //    static void
+  //    for_each(const Binary& b, F&& f) { f(b.lhs); f(b.rhs); }
+  //  };
+  //for_each calls f with each child variant in order.
+  template <typename T>
+  struct tree_children;
+
+  template <typename Variant>
+  class flat_tree;
+
+  namespace detail
+  {
+    template <typename T>
+    struct flat_payload
+    {
+      typedef T type;
+
+      static const T&
+      get(const T& t)
+      {
+        return t;
+      }
+    };
+
+    template <typename T, typename Allocator>
+    struct flat_payload<recursive_wrapper<T, Allocator>>
+    {
+      typedef typename tree_children<T>::payload_type type;
+
+      static type
+      get(const recursive_wrapper<T, Allocator>& w)
+      {
+        return tree_children<T>::payload(w.get());
+      }
+    };
+
+    template <typename Variant>
+    struct flat_variant;
+
+    template <typename... Types>
+    struct flat_variant<variant<Types...>>
+    {
+      typedef variant<typename flat_payload<Types>::type...> type;
+    };
+
+    template <typename Variant>
+    using flat_variant_t = typename flat_variant<Variant>::type;
+
+    //the payload of the I'th alternative
+    struct payload_caller
+    {
+      template <size_t I, typename Variant>
+      static flat_variant_t<std::decay_t<Variant>>
+      call(const Variant& v)
+      {
+        typedef std::decay_t<Variant> plain;
+        return flat_variant_t<plain>(emplaced_index_t<I>(),
+          flat_payload<std::tuple_element_t<I, plain>>::get(
+            variant_access::get<I>(v)));
+      }
+    };
+
+    //calls the visitor with the payload of the I'th alternative
+    template <typename R>
+    struct payload_visitor_caller
+    {
+      template <size_t I, typename Visitor, typename Variant>
+      static R
+      call(Visitor&& visitor, const Variant& v)
+      {
+        return visitor(flat_payload<
+          std::tuple_element_t<I, std::decay_t<Variant>>
+        >::get(variant_access::get<I>(v)));
+      }
+    };
+
+    template <typename T>
+    struct children_caller
+    {
+      template <typename F>
+      static void
+      for_each(const T&, F&&)
+      {
+        //not a recursive_wrapper, so no children
+      }
+    };
+
+    template <typename T, typename Allocator>
+    struct children_caller<recursive_wrapper<T, Allocator>>
+    {
+      template <typename F>
+      static void
+      for_each(const recursive_wrapper<T, Allocator>& w, F&& f)
+      {
+        tree_children<T>::for_each(w.get(), f);
+      }
+    };
+
+    //calls f with the children of the I'th alternative
+    struct for_each_child_caller
+    {
+      template <size_t I, typename F, typename Variant>
+      static void
+      call(F&& f, const Variant& v)
+      {
+        children_caller<
+          std::tuple_element_t<I, std::decay_t<Variant>>
+        >::for_each(variant_access::get<I>(v), f);
+      }
+    };
+  }
+
+  //A node of a flat_tree, which refers to the tree that it is in.
+  template <typename Variant>
+  class flat_node
+  {
+    public:
+    typedef detail::flat_variant_t<Variant> value_type;
+
+    flat_node(const flat_tree<Variant>* tree, std::uint32_t index)
+    : m_tree(tree), m_index(index)
+    {
+    }
+
+    const value_type&
+    value() const
+    {
+      return entry().value;
+    }
+
+    //the position of the node in breadth first order
+    size_t
+    index() const
+    {
+      return m_index;
+    }
+
+    size_t
+    children() const
+    {
+      return entry().children;
+    }
+
+    flat_node
+    child(size_t i) const
+    {
+      assert(i < children());
+      return flat_node(m_tree,
+        static_cast<std::uint32_t>(entry().first_child + i));
+    }
+
+    private:
+    const flat_tree<Variant>* m_tree;
+    std::uint32_t m_index;
+
+    const typename flat_tree<Variant>::entry&
+    entry() const
+    {
+      return m_tree->m_nodes[m_index];
+    }
+  };
+
+  template <typename... Types>
+  class flat_tree<variant<Types...>>
+  {
+    public:
+    typedef variant<Types...> tree_type;
+    typedef detail::flat_variant_t<tree_type> value_type;
+    typedef flat_node<tree_type> node;
+
+    explicit flat_tree(const tree_type& root)
+    {
+      //the variants that the nodes were made from, in the same order
+      std::vector<const tree_type*> pending{&root};
+      m_nodes.push_back(make_entry(root));
+
+      for (size_t i = 0; i != pending.size(); ++i)
+      {
+        std::uint32_t first = static_cast<std::uint32_t>(m_nodes.size());
+        std::uint32_t children = 0;
+
+        visit_children(*pending[i], [&] (const tree_type& child) {
+          //the nodes are indexed by 32 bits
+          if (JUICE_UNLIKELY(m_nodes.size() >=
+                std::numeric_limits<std::uint32_t>::max()))
+          {
+            detail::raise<std::length_error>("flat_tree has too many nodes");
+          }
+          pending.push_back(&child);
+          m_nodes.push_back(make_entry(child));
+          ++children;
+        });
+
+        m_nodes[i].first_child = first;
+        m_nodes[i].children = children;
+      }
+    }
+
+    node
+    root() const
+    {
+      return node(this, 0);
+    }
+
+    size_t
+    size() const
+    {
+      return m_nodes.size();
+    }
+
+    //the nodes in breadth first order
+    node
+    operator[](size_t i) const
+    {
+      assert(i < size());
+      return node(this, static_cast<std::uint32_t>(i));
+    }
+
+    private:
+    struct entry
+    {
+      value_type value;
+      std::uint32_t first_child;
+      std::uint32_t children;
+    };
+
+    std::vector<entry> m_nodes;
+
+    friend class flat_node<tree_type>;
+
+    static entry
+    make_entry(const tree_type& v)
+    {
+      return entry{
+        detail::dispatcher
+        <
+          value_type,
+          sizeof...(Types),
+          detail::payload_caller
+        >::dispatch(v.index(), v),
+        0,
+        0
+      };
+    }
+
+    template <typename F>
+    static void
+    visit_children(const tree_type& v, F&& f)
+    {
+      detail::dispatcher
+      <
+        void,
+        sizeof...(Types),
+        detail::for_each_child_caller
+      >::dispatch(v.index(), f, v);
+    }
+  };
+
+  //Calls visitor with the payload of a node of a tree, which is the
+  //alternative, or the payload of a recursive_wrapper given by
+  //tree_children.
+  template <typename Visitor, typename... Types>
+  decltype(auto)
+  visit_node(Visitor&& visitor, const variant<Types...>& v)
+  {
+    typedef decltype(visit(visitor,
+      std::declval<const detail::flat_variant_t<variant<Types...>>&>()))
+      result;
+
+    return detail::dispatcher
+    <
+      result,
+      sizeof...(Types),
+      detail::payload_visitor_caller<result>
+    >::dispatch(v.index(), visitor, v);
+  }
+
+  template <typename Visitor, typename Variant>
+  decltype(auto)
+  visit_node(Visitor&& visitor, const flat_node<Variant>& n)
+  {
+    return visit(visitor, n.value());
+  }
+
+  //Calls f with each child of a node of a tree, which are variants for a
+  //variant and flat_nodes for a flat_node.
+  template <typename F, typename... Types>
+  void
+  for_each_child(const variant<Types...>& v, F&& f)
+  {
+    detail::dispatcher
+    <
+      void,
+      sizeof...(Types),
+      detail::for_each_child_caller
+    >::dispatch(v.index(), f, v);
+  }
+
+  template <typename F, typename Variant>
+  void
+  for_each_child(const flat_node<Variant>& n, F&& f)
+  {
+    for (size_t i = 0; i != n.children(); ++i)
+    {
+      f(n.child(i));
+    }
+  }
+}
+
+#endif
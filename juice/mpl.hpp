@@ -34,66 +34,64 @@ do so, all subject to the following:
 
 #include <type_traits>
 #include <cstdlib>
+#include <utility>
 
 namespace juice
 {
 
   namespace detail
   {
-    template 
-    <
-      template <typename> class Size,
-      typename SoFar, 
-      typename... Args
-     >
-    struct max_helper;
-
-    template 
-    <
-      template <typename> class Size,
-      typename SoFar
-    >
-    struct max_helper<Size, SoFar>
+    template <typename... Types>
+    struct pack_first;
+
+    template <typename First, typename... Types>
+    struct pack_first<First, Types...>
     {
-      static constexpr decltype(Size<SoFar>::value) value = 
-        Size<SoFar>::value;
-      typedef SoFar type;
+      typedef First type;
     };
 
-    template 
-    <
-      template <typename> class Size,
-      typename SoFar, 
-      typename Next, 
-      typename... Args
-    >
-    struct max_helper<Size, SoFar, Next, Args...>
+    template <size_t I, typename T>
+    struct pack_indexed
     {
-      private:
-      typedef typename std::conditional
-      <
-        (Size<Next>::value > Size<SoFar>::value),
-        max_helper<Size, Next, Args...>,
-        max_helper<Size, SoFar, Args...>
-      >::type m_next;
-
-      public:
-      static constexpr decltype(Size<SoFar>::value) value = 
-        m_next::value;
-
-      typedef typename m_next::type type;
+      typedef T type;
     };
 
-    template <typename... Types>
-    struct pack_first;
+    template <typename Seq, typename... Types>
+    struct pack_indexer;
 
-    template <typename First, typename... Types>
-    struct pack_first<First, Types...>
+    template <size_t... I, typename... Types>
+    struct pack_indexer<std::index_sequence<I...>, Types...> :
+      public pack_indexed<I, Types>...
     {
-      typedef First type;
     };
+
+    //overload resolution picks the base for I out of all of them at once
+    template <size_t I, typename T>
+    pack_indexed<I, T>
+    pack_select(const pack_indexed<I, T>&);
+
+    template <size_t I, typename... Types>
+    using pack_element_t = typename decltype(pack_select<I>(
+      pack_indexer<std::index_sequence_for<Types...>, Types...>()))::type;
+
+    //the index of the first largest of sizes
+    template <typename T, size_t N>
+    constexpr size_t
+    max_index(const T (&sizes)[N])
+    {
+      size_t best = 0;
+      for (size_t i = 1; i != N; ++i)
+      {
+        if (sizes[i] > sizes[best])
+        {
+          best = i;
+        }
+      }
+      return best;
+    }
   }
 
+  //The first of Args with the largest Size<T>::value, and that value.
   template <template <typename> class Size, typename... Args>
   struct max;
 
@@ -107,16 +105,15 @@ namespace juice
   {
     private:
     typedef decltype(Size<First>::value) m_size_type;
-    typedef detail::max_helper
-    <
-      Size, 
-      First, 
-      Args...
-    > m_helper;
+
+    static constexpr size_t m_index = detail::max_index<m_size_type>({
+      Size<First>::value,
+      static_cast<m_size_type>(Size<Args>::value)...
+    });
 
     public:
-    static constexpr m_size_type value = m_helper::value;
-    typedef typename m_helper::type type;
+    typedef detail::pack_element_t<m_index, First, Args...> type;
+    static constexpr m_size_type value = Size<type>::value;
   };
 
 }
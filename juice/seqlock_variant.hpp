@@ -0,0 +1,184 @@
+/* A variant of trivially copyable types behind a sequence lock.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// seqlock_variant<Types...> holds a variant<Types...> that is read far more
+// often than it is written. A reader copies the bytes of the variant, its
+// storage and index together, between two reads of a sequence counter, and
+// copies them again if a writer was part way through. Readers never write
+// to shared memory, so they don't contend with each other, and never wait
+// for a lock. Writers take a mutex among themselves and make the counter
+// odd while they write.
+//
+// Every alternative must be trivially copyable, so that a variant can be
+// copied as bytes and a torn copy is never used as a value. The bytes are
+// kept as relaxed atomic words, so a read racing with a write is not a data
+// race.
+
+#ifndef JUICE_SEQLOCK_VARIANT_HPP_INCLUDED
+#define JUICE_SEQLOCK_VARIANT_HPP_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "variant.hpp"
+
+namespace juice
+{
+  template <typename... Types>
+  class seqlock_variant
+  {
+    public:
+    typedef variant<Types...> value_type;
+
+    static_assert(conjunction<
+        std::is_trivially_copyable<Types>::value...
+      >::value, "seqlock_variant needs trivially copyable alternatives");
+    static_assert(alignof(value_type) <= alignof(std::uint64_t),
+      "seqlock_variant can't hold over-aligned alternatives");
+
+    seqlock_variant()
+    : seqlock_variant(value_type())
+    {
+    }
+
+    seqlock_variant(const value_type& v)
+    : m_sequence(0)
+    {
+      write(v);
+    }
+
+    seqlock_variant(const seqlock_variant&) = delete;
+
+    seqlock_variant&
+    operator=(const seqlock_variant&) = delete;
+
+    seqlock_variant&
+    operator=(const value_type& v)
+    {
+      store(v);
+      return *this;
+    }
+
+    //Copies the value, trying again until no writer got in the way.
+    value_type
+    load() const
+    {
+      std::uint64_t words[word_count];
+      for (;;)
+      {
+        std::uint64_t before = m_sequence.load(std::memory_order_acquire);
+        if (before % 2 == 0)
+        {
+          for (size_t i = 0; i != word_count; ++i)
+          {
+            words[i] = m_words[i].load(std::memory_order_relaxed);
+          }
+
+          std::atomic_thread_fence(std::memory_order_acquire);
+          if (m_sequence.load(std::memory_order_relaxed) == before)
+          {
+            break;
+          }
+        }
+
+        std::this_thread::yield();
+      }
+
+      return from_words(words);
+    }
+
+    void
+    store(const value_type& v)
+    {
+      std::lock_guard<std::mutex> lock(m_writer);
+      write(v);
+    }
+
+    //Calls f with a copy of the value and stores the result, with no other
+    //writer in between.
+    template <typename F>
+    void
+    update(F&& f)
+    {
+      std::lock_guard<std::mutex> lock(m_writer);
+      value_type v = load();
+      f(v);
+      write(v);
+    }
+
+    //the number of completed writes
+    std::uint64_t
+    version() const
+    {
+      return m_sequence.load(std::memory_order_acquire) / 2;
+    }
+
+    private:
+    static constexpr size_t word_count =
+      (sizeof(value_type) + sizeof(std::uint64_t) - 1) /
+      sizeof(std::uint64_t);
+
+    std::atomic<std::uint64_t> m_sequence;
+    std::atomic<std::uint64_t> m_words[word_count];
+    std::mutex m_writer;
+
+    //the caller must hold m_writer, or be the constructor
+    void
+    write(const value_type& v)
+    {
+      std::uint64_t words[word_count] = {};
+      std::memcpy(words, static_cast<const void*>(&v), sizeof(value_type));
+
+      std::uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+      m_sequence.store(sequence + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+
+      for (size_t i = 0; i != word_count; ++i)
+      {
+        m_words[i].store(words[i], std::memory_order_relaxed);
+      }
+
+      m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    static value_type
+    from_words(const std::uint64_t* words)
+    {
+      std::aligned_storage_t<sizeof(value_type), alignof(value_type)> bytes;
+      std::memcpy(&bytes, words, sizeof(value_type));
+      return *reinterpret_cast<const value_type*>(&bytes);
+    }
+  };
+}
+
+#endif
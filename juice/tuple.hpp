@@ -1,46 +1,56 @@
+#include <cstddef>
+#include <memory>
 #include <tuple>
+#include <type_traits>
 
 namespace juice
 {
   template <typename... Types>
   class variant;
 
-  template <typename T>
+  template <typename T, typename Allocator = std::allocator<T>>
   class recursive_wrapper;
 
   static constexpr const size_t tuple_not_found = (size_t) -1;
   template <typename T, typename U> struct tuple_find;
 
-  template <size_t N, typename T, typename... Types>
-  struct tuple_find_helper;
-
-  template <size_t N, typename T, typename First, typename... Types>
-  struct tuple_find_helper<N, T, First, Types...> :
-    public tuple_find_helper<N+1, T, Types...>
-  {
-  };
-
-  template <size_t N, typename T, typename... Types>
-  struct tuple_find_helper<N, T, recursive_wrapper<T>, Types...> :
-    public std::integral_constant<std::size_t, N>
+  namespace detail
   {
-  };
-
-  template <size_t N, typename T, typename... Types>
-  struct tuple_find_helper<N, T, T, Types...> :
-    public std::integral_constant<std::size_t, N>
-  {
-  };
-
-  template <size_t N, typename T>
-  struct tuple_find_helper<N, T> :
-    public std::integral_constant<decltype(tuple_not_found), tuple_not_found>
-  {
-  };
+    //T is found as itself, or as a recursive_wrapper<T>
+    template <typename T, typename U>
+    struct tuple_matches : public std::is_same<T, U>
+    {
+    };
+
+    template <typename T, typename Allocator>
+    struct tuple_matches<T, recursive_wrapper<T, Allocator>> :
+      public std::true_type
+    {
+    };
+
+    //the first match is found by a loop in a constexpr function, so that
+    //there is no instantiation per type
+    template <typename T, typename... Types>
+    constexpr size_t
+    tuple_index()
+    {
+      constexpr bool matches[] = {tuple_matches<T, Types>::value..., false};
+
+      for (size_t i = 0; i != sizeof...(Types); ++i)
+      {
+        if (matches[i])
+        {
+          return i;
+        }
+      }
+
+      return tuple_not_found;
+    }
+  }
 
   template <typename T, typename... Types>
   struct tuple_find<T, std::tuple<Types...>> :
-    public tuple_find_helper<0, T, Types...>
+    public std::integral_constant<size_t, detail::tuple_index<T, Types...>()>
   {
   };
 
@@ -35,6 +35,8 @@ do so, all subject to the following:
 // In summary:
 //   1. It is almost never empty, and visiting an empty variant is undefined.
 //   2. Accessing the wrong element throws. But the variant must still be valid.
+//      It can abort instead, see JUICE_VARIANT_ABORT_ON_BAD_ACCESS, and
+//      try_get reports the error without either.
 //   3. The copy/move assignment operators follow the exception safety of
 //      the contained types, and guarantee that the variant will not be empty
 //      as long as the last copy or move does not throw.
@@ -46,7 +48,6 @@ do so, all subject to the following:
 // the visitor.
 //
 // == Notes ==
-// Hash is not yet implemented.
 // Some of the visitors have operator()() lying around from trying a previous
 // proposal with empty visitation.
 
@@ -55,17 +56,94 @@ do so, all subject to the following:
 #define JUICE_VARIANT_HPP_INCLUDED
 
 #include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <initializer_list>
+#include <limits>
+#include <memory>
 #include <new>
-#include <typeindex>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
 #include <utility>
 
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+#endif
+
 #include "conjunction.hpp"
 #include "mpl.hpp"
 #include "tuple.hpp"
 
+#ifdef JUICE_VARIANT_PROFILE
+#include "variant_profile.hpp"
+#define JUICE_VARIANT_COUNT(event, Variant, which) \
+  ::juice::profile::detail::count<Variant>(::juice::profile::event, which)
+#else
+#define JUICE_VARIANT_COUNT(event, Variant, which) ((void)0)
+#endif
+
+//Visitation of variants with at most this many alternatives is dispatched
+//with a switch, larger variants use a table of function pointers.
+//It can be lowered, but there are only 32 cases in the switch.
+#ifndef JUICE_VARIANT_SWITCH_LIMIT
+#define JUICE_VARIANT_SWITCH_LIMIT 32
+#endif
+
+#if JUICE_VARIANT_SWITCH_LIMIT > 32
+#error "JUICE_VARIANT_SWITCH_LIMIT cannot be more than 32"
+#endif
+
+#if defined(__GNUC__)
+#define JUICE_UNREACHABLE() __builtin_unreachable()
+#elif defined(_MSC_VER)
+#define JUICE_UNREACHABLE() __assume(0)
+#else
+#define JUICE_UNREACHABLE() std::abort()
+#endif
+
+#if defined(__GNUC__)
+#define JUICE_LIKELY(x) __builtin_expect(!!(x), 1)
+#define JUICE_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define JUICE_LIKELY(x) (x)
+#define JUICE_UNLIKELY(x) (x)
+#endif
+
+//The error paths are kept out of line so that an access only costs a
+//compare and a branch where it is inlined.
+#if defined(__GNUC__)
+#define JUICE_COLD __attribute__((cold, noinline))
+#elif defined(_MSC_VER)
+#define JUICE_COLD __declspec(noinline)
+#else
+#define JUICE_COLD
+#endif
+
+//Without exceptions, which is detected or can be asked for by defining
+//JUICE_NO_EXCEPTIONS, every error that would throw aborts instead, and
+//JUICE_TRY and JUICE_CATCH_ALL compile only the body of the try.
+//Defining JUICE_VARIANT_ABORT_ON_BAD_ACCESS aborts on accessing the wrong
+//alternative even with exceptions.
+#if !defined(JUICE_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && \
+  !defined(__EXCEPTIONS) && !defined(_CPPUNWIND)
+#define JUICE_NO_EXCEPTIONS
+#endif
+
+#ifdef JUICE_NO_EXCEPTIONS
+#define JUICE_TRY if (true)
+#define JUICE_CATCH_ALL else
+#define JUICE_RETHROW ((void)0)
+#else
+#define JUICE_TRY try
+#define JUICE_CATCH_ALL catch (...)
+#define JUICE_RETHROW throw
+#endif
+
 namespace juice
 {
   namespace MPL
@@ -79,6 +157,25 @@ namespace juice
   template <size_t I> struct emplaced_index_t {};
   template <size_t I> constexpr emplaced_index_t<I> emplaced_index{};
 
+  //A list of alternatives that are likely to be held, most likely first.
+  template <typename... Types>
+  struct likely {};
+
+  //The alternatives that visit of a single Variant compares the index with
+  //first, inline and in order, before the general dispatch. It can be
+  //specialised by hand or with the header that profile::write_hints
+  //writes, for example
+  //  template <>
+  //  struct dispatch_hint<variant<int, std::string>>
+  //  {
+  //    typedef likely<int> type;
+  //  };
+  template <typename Variant>
+  struct dispatch_hint
+  {
+    typedef likely<> type;
+  };
+
   template <typename R = void>
   class
   [[deprecated("result_type is not used anymore")]]
@@ -92,13 +189,204 @@ namespace juice
     ~static_visitor() = default;
   };
 
-  template <typename T>
+  namespace detail
+  {
+    //A recursive_wrapper waiting to be destroyed. The allocator that frees
+    //it is copied into the entry.
+    struct teardown_entry
+    {
+      void (*destroy)(void* node, const void* allocator);
+      void* node;
+      alignas(void*) unsigned char allocator[sizeof(void*)];
+    };
+
+    //The recursive_wrappers of a thread that are waiting to be destroyed.
+    //It is trivial so that the thread_local needs no guard.
+    struct teardown_list
+    {
+      static constexpr size_t inline_capacity = 16;
+
+      //how deep recursive_wrappers are destroyed by recursion before they
+      //are left to the worklist
+      static constexpr size_t recursion_limit = 64;
+
+      teardown_entry* entries;
+      size_t size;
+      size_t capacity;
+      size_t depth;
+      teardown_entry inline_entries[inline_capacity];
+
+      //returns false if there is no memory for the entry
+      bool
+      push(const teardown_entry& e)
+      {
+        if (size == capacity)
+        {
+          size_t grown = capacity == 0 ? inline_capacity : capacity * 2;
+          teardown_entry* larger;
+          if (capacity == 0)
+          {
+            larger = inline_entries;
+          }
+          else if (entries == inline_entries)
+          {
+            larger = static_cast<teardown_entry*>(
+              std::malloc(grown * sizeof(teardown_entry)));
+            if (larger != nullptr)
+            {
+              std::memcpy(larger, entries, size * sizeof(teardown_entry));
+            }
+          }
+          else
+          {
+            larger = static_cast<teardown_entry*>(
+              std::realloc(entries, grown * sizeof(teardown_entry)));
+          }
+
+          if (larger == nullptr)
+          {
+            return false;
+          }
+
+          entries = larger;
+          capacity = grown;
+        }
+
+        entries[size++] = e;
+        return true;
+      }
+
+      //destroys everything in the list, called by the outermost teardown
+      void
+      drain()
+      {
+        ++depth;
+        while (size != 0)
+        {
+          teardown_entry e = entries[--size];
+          e.destroy(e.node, e.allocator);
+        }
+        --depth;
+
+        if (entries != inline_entries)
+        {
+          std::free(entries);
+        }
+        entries = nullptr;
+        capacity = 0;
+      }
+    };
+
+    inline teardown_list&
+    teardown_worklist()
+    {
+      static thread_local teardown_list list;
+      return list;
+    }
+
+    //Destroys the T of a recursive_wrapper with a bounded stack. The
+    //recursive_wrappers inside it are destroyed by recursion down to
+    //recursion_limit, below that they are pushed onto the worklist of the
+    //thread, which the outermost teardown drains in a loop. So a tree of
+    //any depth can be destroyed, and a shallow one costs no more than
+    //recursion.
+    //An allocator that can't be copied into an entry is always destroyed by
+    //recursion, as is everything if the worklist can't grow.
+    template <typename T, typename Allocator>
+    struct teardown
+    {
+      typedef std::allocator_traits<Allocator> traits;
+
+      //The entries are moved around with memcpy and the copies of the
+      //allocator are never destroyed, which is fine for an empty allocator
+      //such as std::allocator, and a trivial one such as
+      //std::pmr::polymorphic_allocator.
+      static constexpr bool deferrable =
+        std::is_same<typename traits::pointer, T*>::value &&
+        (std::is_empty<Allocator>::value ||
+          std::is_trivially_copyable<Allocator>::value) &&
+        sizeof(Allocator) <= sizeof(void*) &&
+        alignof(Allocator) <= alignof(void*);
+
+      static void
+      destroy_now(T* node, Allocator& a)
+      {
+        traits::destroy(a, node);
+        traits::deallocate(a, node, 1);
+      }
+
+      static void
+      destroy_entry(void* node, const void* allocator)
+      {
+        Allocator a(*static_cast<const Allocator*>(allocator));
+        destroy_now(static_cast<T*>(node), a);
+      }
+
+      static void
+      release(T* node, Allocator& a, std::true_type)
+      {
+        teardown_list& list = teardown_worklist();
+        if (list.depth == teardown_list::recursion_limit)
+        {
+          teardown_entry e;
+          e.destroy = &destroy_entry;
+          e.node = node;
+          new (e.allocator) Allocator(a);
+          if (!list.push(e))
+          {
+            destroy_now(node, a);
+          }
+          return;
+        }
+
+        ++list.depth;
+        destroy_now(node, a);
+        --list.depth;
+
+        if (list.depth == 0 && list.size != 0)
+        {
+          list.drain();
+        }
+      }
+
+      template <typename Pointer>
+      static void
+      release(Pointer node, Allocator& a, std::false_type)
+      {
+        traits::destroy(a, std::addressof(*node));
+        traits::deallocate(a, node, 1);
+      }
+
+      template <typename Pointer>
+      static void
+      release(Pointer node, Allocator& a)
+      {
+        release(node, a, std::integral_constant<bool, deferrable>());
+      }
+    };
+  }
+
+  //Holds a T on the heap so that a variant can contain itself. The T is
+  //allocated with Allocator, so that for example a whole tree of recursive
+  //variants can be allocated from one arena and released together. A
+  //recursive_wrapper is constructed with an allocator through
+  //std::allocator_arg, which variant does for uses-allocator construction.
+  template <typename T, typename Allocator>
   class recursive_wrapper
+    : private std::allocator_traits<Allocator>::template rebind_alloc<T>
   {
+    public:
+    typedef typename std::allocator_traits<Allocator>::template
+      rebind_alloc<T> allocator_type;
+
+    private:
+    typedef std::allocator_traits<allocator_type> traits;
+    typedef typename traits::pointer pointer;
+
     public:
     ~recursive_wrapper()
     {
-      delete m_t;
+      destroy(m_t);
     }
 
     template 
@@ -109,7 +397,7 @@ namespace juice
     >
     recursive_wrapper(
       const U& u)
-    : m_t(new T(u))
+    : m_t(create(u))
     {
     }
 
@@ -120,17 +408,49 @@ namespace juice
         typename std::enable_if<std::is_convertible<U, T>::value, U>::type
     >
     recursive_wrapper(U&& u)
-    : m_t(new T(std::forward<U>(u))) { }
+    : m_t(create(std::forward<U>(u))) { }
+
+    template 
+    <
+      typename U,
+      typename Dummy =
+        typename std::enable_if<std::is_convertible<U, T>::value, U>::type
+    >
+    recursive_wrapper(std::allocator_arg_t, const allocator_type& a, U&& u)
+    : allocator_type(a)
+    , m_t(create(std::forward<U>(u))) { }
 
     recursive_wrapper(const recursive_wrapper& rhs)
-    : m_t(new T(rhs.get())) { }
+    : allocator_type(
+        traits::select_on_container_copy_construction(rhs.get_allocator()))
+    , m_t(create(rhs.get())) { }
+
+    recursive_wrapper(std::allocator_arg_t, const allocator_type& a,
+      const recursive_wrapper& rhs)
+    : allocator_type(a)
+    , m_t(create(rhs.get())) { }
 
     recursive_wrapper(recursive_wrapper&& rhs)
-    : m_t(rhs.m_t)
+    : allocator_type(std::move(rhs.allocator()))
+    , m_t(rhs.m_t)
     {
       rhs.m_t = nullptr;
     }
 
+    //the pointer is only taken if it was allocated by an equal allocator,
+    //or if there is none because rhs was moved from
+    recursive_wrapper(std::allocator_arg_t, const allocator_type& a,
+      recursive_wrapper&& rhs)
+    : allocator_type(a)
+    , m_t(rhs.m_t == nullptr || a == rhs.allocator() ? rhs.m_t :
+        create(std::move(rhs.get())))
+    {
+      if (m_t == rhs.m_t)
+      {
+        rhs.m_t = nullptr;
+      }
+    }
+
     recursive_wrapper&
     operator=(const recursive_wrapper& rhs)
     {
@@ -143,10 +463,24 @@ namespace juice
     {
       if (this != &rhs)
       {
-        const T* tmp = m_t;
-        m_t = rhs.m_t;
-        rhs.m_t = nullptr;
-        delete tmp;
+        //the allocator is never replaced, so the pointer can only be taken
+        //when the allocators are equal
+        if (allocator() == rhs.allocator())
+        {
+          pointer tmp = m_t;
+          m_t = rhs.m_t;
+          rhs.m_t = nullptr;
+          destroy(tmp);
+        }
+        else if (rhs.m_t == nullptr)
+        {
+          destroy(m_t);
+          m_t = nullptr;
+        }
+        else
+        {
+          assign(std::move(rhs.get()));
+        }
       }
       return *this;
     }
@@ -174,22 +508,75 @@ namespace juice
     T& get() { return *m_t; }
     const T& get() const { return *m_t; }
 
+    allocator_type get_allocator() const { return allocator(); }
+
     private:
-    T* m_t;
+    pointer m_t;
+
+    allocator_type& allocator() { return *this; }
+    const allocator_type& allocator() const { return *this; }
+
+    template <typename... Args>
+    pointer
+    create(Args&&... args)
+    {
+      pointer p = traits::allocate(allocator(), 1);
+      JUICE_TRY
+      {
+        traits::construct(allocator(), std::addressof(*p),
+          std::forward<Args>(args)...);
+      }
+      JUICE_CATCH_ALL
+      {
+        traits::deallocate(allocator(), p, 1);
+        JUICE_RETHROW;
+      }
+      return p;
+    }
 
+    //this doesn't recurse into the recursive_wrappers in *p
+    void
+    destroy(pointer p)
+    {
+      if (p != nullptr)
+      {
+        detail::teardown<T, allocator_type>::release(p, allocator());
+      }
+    }
+
+    //a moved from wrapper has no node to assign to
     template <typename U>
     void
     assign(U&& u)
     {
-      *m_t = std::forward<U>(u);
+      if (m_t == nullptr)
+      {
+        m_t = create(std::forward<U>(u));
+      }
+      else
+      {
+        *m_t = std::forward<U>(u);
+      }
     }
   };
 
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+  namespace pmr
+  {
+    //a recursive_wrapper that allocates from a std::pmr::memory_resource
+    template <typename T>
+    using recursive_wrapper =
+      juice::recursive_wrapper<T, std::pmr::polymorphic_allocator<T>>;
+  }
+#endif
+#endif
+
   template <typename T>
   struct is_recursive_wrapper : public std::false_type {};
 
-  template <typename T>
-  struct is_recursive_wrapper<recursive_wrapper<T>>
+  template <typename T, typename Allocator>
+  struct is_recursive_wrapper<recursive_wrapper<T, Allocator>>
     : public std::true_type {};
 
   template <typename T>
@@ -198,8 +585,8 @@ namespace juice
     typedef T type;
   };
 
-  template <typename T>
-  struct unwrapped_type<recursive_wrapper<T>>
+  template <typename T, typename Allocator>
+  struct unwrapped_type<recursive_wrapper<T, Allocator>>
   {
     typedef T type;
   };
@@ -207,36 +594,36 @@ namespace juice
   template <typename T>
   using unwrapped_type_t = typename unwrapped_type<T>::type;
 
-  template <typename T>
-  const T&
-  recursive_unwrap(const recursive_wrapper<T>& r)
+  template <typename T, typename Allocator>
+  constexpr const T&
+  recursive_unwrap(const recursive_wrapper<T, Allocator>& r)
   {
     return r.get();
   }
 
-  template <typename T>
-  T&
-  recursive_unwrap(recursive_wrapper<T>& r)
+  template <typename T, typename Allocator>
+  constexpr T&
+  recursive_unwrap(recursive_wrapper<T, Allocator>& r)
   {
     return r.get();
   }
 
   template <typename T>
-  const T&
+  constexpr const T&
   recursive_unwrap(const T& t)
   {
     return t;
   }
 
   template <typename T>
-  T&
+  constexpr T&
   recursive_unwrap(T& t)
   {
     return t;
   }
 
   template <typename T>
-  T&&
+  constexpr T&&
   recursive_unwrap(T&& t)
   {
     return std::move(t);
@@ -244,31 +631,39 @@ namespace juice
 
   namespace detail
   {
+    //the value keeps the value category of t
     template <typename T, typename Internal>
-    T&
+    constexpr T&&
     get_value(T&& t, const Internal&)
     {
       using Plain = std::remove_reference_t<T>;
       static_assert(std::is_same<MPL::true_, Internal>::value ||
         !is_recursive_wrapper<Plain>::value,
         "recursive wrapper in generic get");
-      return t;
+      return std::forward<T>(t);
     }
 
-    template <typename T>
-    T&
-    get_value(recursive_wrapper<T>& t, const MPL::false_&)
+    template <typename T, typename Allocator>
+    constexpr T&
+    get_value(recursive_wrapper<T, Allocator>& t, const MPL::false_&)
     {
       return t.get();
     }
 
-    template <typename T>
-    const T&
-    get_value(const recursive_wrapper<T>& t, const MPL::false_&)
+    template <typename T, typename Allocator>
+    constexpr const T&
+    get_value(const recursive_wrapper<T, Allocator>& t, const MPL::false_&)
     {
       return t.get();
     }
 
+    template <typename T, typename Allocator>
+    constexpr T&&
+    get_value(recursive_wrapper<T, Allocator>&& t, const MPL::false_&)
+    {
+      return std::move(t.get());
+    }
+
     template <typename Visitor, typename Visitable>
     struct BinaryVisitor
     {
@@ -294,25 +689,6 @@ namespace juice
       Visitable& visitable;
     };
 
-    struct
-    swapper
-    {
-      template <typename T>
-      void
-      operator()(T& t, T& rhs)
-      {
-        std::swap(t, rhs);
-      }
-
-      template <typename T, typename U>
-      void
-      operator()(T&, U&)
-      {
-        //this should never be called
-        assert(false);
-      }
-    };
-
     template <typename T, typename... Types>
     struct variant_universal_check
     {
@@ -322,6 +698,113 @@ namespace juice
       ;
     };
 
+    template <typename T>
+    struct is_variant : public std::false_type {};
+
+    template <typename... Types>
+    struct is_variant<variant<Types...>> : public std::true_type {};
+
+    //the number of variants at the front of Values
+    template <typename... Values>
+    struct leading_variants : public std::integral_constant<size_t, 0> {};
+
+    template <typename First, typename... Values>
+    struct leading_variants<First, Values...>
+      : public std::integral_constant<size_t,
+          is_variant<std::decay_t<First>>::value
+          ? 1 + leading_variants<Values...>::value
+          : 0
+        >
+    {
+    };
+
+    //How uses-allocator construction passes an allocator to a T
+    //constructed from Args: not at all, after std::allocator_arg at the
+    //front, or at the back.
+    struct allocator_unused {};
+    struct allocator_leading {};
+    struct allocator_trailing {};
+
+    template <typename T, typename Alloc, typename... Args>
+    using allocator_construction_t = std::conditional_t
+    <
+      !std::uses_allocator<T, Alloc>::value,
+      allocator_unused,
+      std::conditional_t
+      <
+        std::is_constructible
+        <
+          T, std::allocator_arg_t, const Alloc&, Args...
+        >::value,
+        allocator_leading,
+        allocator_trailing
+      >
+    >;
+
+    template <typename T, typename Alloc, typename... Args>
+    void
+    construct_with_allocator(allocator_unused, void* p, const Alloc&,
+      Args&&... args)
+    {
+      new (p) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T, typename Alloc, typename... Args>
+    void
+    construct_with_allocator(allocator_leading, void* p, const Alloc& a,
+      Args&&... args)
+    {
+      new (p) T(std::allocator_arg, a, std::forward<Args>(args)...);
+    }
+
+    template <typename T, typename Alloc, typename... Args>
+    void
+    construct_with_allocator(allocator_trailing, void* p, const Alloc& a,
+      Args&&... args)
+    {
+      new (p) T(std::forward<Args>(args)..., a);
+    }
+
+    //unchecked access to the storage of a variant
+    struct variant_access;
+
+    //compares the alternatives of two variants that hold the same one
+    struct equal_caller;
+    struct compare_caller;
+
+    //The signed type used to store the index of a variant with N
+    //alternatives. The valueless state is stored as -1, which converts to
+    //tuple_not_found.
+    template <size_t N>
+    using variant_index_t = std::conditional_t
+    <
+      (N <= std::numeric_limits<signed char>::max()),
+      signed char,
+      std::conditional_t
+      <
+        (N <= std::numeric_limits<short>::max()),
+        short,
+        std::conditional_t
+        <
+          (N <= std::numeric_limits<int>::max()),
+          int,
+          std::make_signed_t<size_t>
+        >
+      >
+    >;
+
+#ifdef JUICE_VARIANT_PROFILE
+    template <typename Variant>
+    using variant_profiler = profile::detail::counter<Variant>;
+#else
+    //An empty base of variant. With JUICE_VARIANT_PROFILE it counts the
+    //constructions and assignments of the variant, see variant_profile.hpp.
+    template <typename Variant>
+    struct variant_profiler
+    {
+    };
+#endif
+
   }    
 
   struct monostate {};
@@ -353,69 +836,290 @@ namespace juice
     }
   };
 
-  template 
-  <
-    typename Internal,
-    typename T, 
-    typename Storage, 
-    typename Visitor, 
-    typename... Args
-  >
-  decltype(auto)
-  visitor_caller(Internal&& internal, 
-    Storage&& storage, Visitor&& visitor, Args&&... args)
+  namespace detail
   {
-    using Bare = typename std::remove_pointer_t<
-      std::remove_reference_t<Storage>
-    >;
-
-    using ConstType = typename std::conditional
-    <
-      std::is_const<Bare>::value,
-      const T,
-      T
-    >::type;
+    //throws an Exception made from args, or aborts without exceptions
+    template <typename Exception, typename... Args>
+    [[noreturn]] JUICE_COLD void
+    raise(const Args&... args)
+    {
+#ifdef JUICE_NO_EXCEPTIONS
+      using expand = int[];
+      (void)expand{0, ((void)args, 0)...};
+      std::abort();
+#else
+      throw Exception(args...);
+#endif
+    }
 
-    using RefType = typename std::conditional
-    <
-      std::is_reference<Storage>::value,
-      ConstType&,
-      ConstType
-    >::type;
+    [[noreturn]] JUICE_COLD inline void
+    raise_bad_access()
+    {
+#ifdef JUICE_VARIANT_ABORT_ON_BAD_ACCESS
+      std::abort();
+#else
+      raise<bad_variant_access>("Tuple does not contain requested item");
+#endif
+    }
 
-    return visitor(detail::get_value(reinterpret_cast<RefType>(*storage),
-      internal), std::forward<Args>(args)...);
+    //the I'th alternative was asked for when Variant holds another
+    template <typename Variant, size_t I>
+    [[noreturn]] JUICE_COLD void
+    bad_access()
+    {
+      JUICE_VARIANT_COUNT(bad_access, Variant, I);
+      raise_bad_access();
+    }
   }
 
+  //Why try_get has no alternative to give.
+  enum class access_error : unsigned char
+  {
+    none,
+    wrong_alternative,
+    valueless
+  };
+
+  //The result of try_get, which refers to the alternative, or otherwise has
+  //the error. It neither throws nor aborts, asking for the value of an
+  //error is undefined. T is a reference for a reference alternative.
   template <typename T>
-  struct ref
+  class access_result
   {
-    static_assert(std::is_reference<T>::value,
-      "Can only be used with references");
-    ref(T t)
-    : m_t(std::forward<T>(t))
+    typedef std::remove_reference_t<T>* pointer;
+
+    public:
+    constexpr access_result(T& value)
+    : m_value(&value), m_error(access_error::none)
     {
     }
 
-    operator T() const {
-      return static_cast<T>(m_t);
+    constexpr access_result(access_error error)
+    : m_value(nullptr), m_error(error)
+    {
     }
 
-    private:
-    T m_t;
-  };
+    constexpr bool
+    has_value() const
+    {
+      return m_value != nullptr;
+    }
 
-  template <typename T, bool = std::is_reference<T>::value>
-  struct ref_type;
+    constexpr explicit operator bool() const
+    {
+      return has_value();
+    }
 
-  template <typename T>
-  struct ref_type<T, true>
-  {
-    typedef ref<T> type;
-  };
+    constexpr T&
+    value() const
+    {
+      assert(has_value());
+      return *m_value;
+    }
 
-  template <typename T>
-  struct ref_type<T, false>
+    constexpr T&
+    operator*() const
+    {
+      return value();
+    }
+
+    constexpr pointer
+    operator->() const
+    {
+      return &value();
+    }
+
+    constexpr T&
+    value_or(T& other) const
+    {
+      return has_value() ? *m_value : other;
+    }
+
+    constexpr access_error
+    error() const
+    {
+      return m_error;
+    }
+
+    private:
+    pointer m_value;
+    access_error m_error;
+  };
+
+  namespace detail
+  {
+    //Calls Caller::call<I> for a runtime index I < N.
+    //Up to JUICE_VARIANT_SWITCH_LIMIT alternatives this expands to a switch,
+    //so the optimiser sees every case and can inline the visitor into the
+    //caller. Beyond that it is a constant table of function pointers, which
+    //needs no static initialisation guard.
+    template
+    <
+      typename R,
+      size_t N,
+      typename Caller,
+      bool = (N <= JUICE_VARIANT_SWITCH_LIMIT)
+    >
+    struct dispatcher;
+
+    template <typename R, size_t N, typename Caller>
+    struct dispatcher<R, N, Caller, true>
+    {
+      template <size_t I, typename... Args>
+      static constexpr R
+      call_case(std::true_type, Args&&... args)
+      {
+        return Caller::template call<I>(std::forward<Args>(args)...);
+      }
+
+      template <size_t I, typename... Args>
+      static constexpr R
+      call_case(std::false_type, Args&&...)
+      {
+        //the index is out of range of the variant
+        JUICE_UNREACHABLE();
+      }
+
+      template <typename... Args>
+      static constexpr R
+      dispatch(size_t which, Args&&... args)
+      {
+#define JUICE_VARIANT_CASE(I) \
+        case I: \
+          return call_case<I>(std::integral_constant<bool, (I < N)>(), \
+            std::forward<Args>(args)...);
+#define JUICE_VARIANT_CASE4(I) \
+        JUICE_VARIANT_CASE(I) JUICE_VARIANT_CASE(I + 1) \
+        JUICE_VARIANT_CASE(I + 2) JUICE_VARIANT_CASE(I + 3)
+
+        switch (which)
+        {
+          JUICE_VARIANT_CASE4(0)
+          JUICE_VARIANT_CASE4(4)
+          JUICE_VARIANT_CASE4(8)
+          JUICE_VARIANT_CASE4(12)
+          JUICE_VARIANT_CASE4(16)
+          JUICE_VARIANT_CASE4(20)
+          JUICE_VARIANT_CASE4(24)
+          JUICE_VARIANT_CASE4(28)
+        }
+
+#undef JUICE_VARIANT_CASE4
+#undef JUICE_VARIANT_CASE
+
+        JUICE_UNREACHABLE();
+      }
+    };
+
+    //the common type of the results of Caller::invoke<I> for every I in Seq
+    template <typename Caller, typename Seq, typename... Args>
+    struct multi_result;
+
+    template <typename Caller, size_t... I, typename... Args>
+    struct multi_result<Caller, std::index_sequence<I...>, Args...>
+      : public std::common_type<
+          decltype(Caller::template invoke<I>(std::declval<Args>()...))...
+        >
+    {
+    };
+
+    template <typename R, typename Caller, typename Seq, typename... Args>
+    struct dispatch_table;
+
+    template <typename R, typename Caller, size_t... I, typename... Args>
+    struct dispatch_table<R, Caller, std::index_sequence<I...>, Args...>
+    {
+      typedef R (*function)(Args&&...);
+
+      static constexpr function value[sizeof...(I)] =
+      {
+        &Caller::template call<I, Args...>...
+      };
+    };
+
+    template <typename R, typename Caller, size_t... I, typename... Args>
+    constexpr typename
+      dispatch_table<R, Caller, std::index_sequence<I...>, Args...>::function
+      dispatch_table<R, Caller, std::index_sequence<I...>, Args...>::value[
+        sizeof...(I)];
+
+    template <typename R, size_t N, typename Caller>
+    struct dispatcher<R, N, Caller, false>
+    {
+      template <typename... Args>
+      static constexpr R
+      dispatch(size_t which, Args&&... args)
+      {
+        return dispatch_table
+        <
+          R,
+          Caller,
+          std::make_index_sequence<N>,
+          Args...
+        >::value[which](std::forward<Args>(args)...);
+      }
+    };
+
+    //Compares which with each of Hot in turn and calls Caller for the
+    //first that matches inline, before falling back to the dispatcher.
+    template <typename R, size_t N, typename Caller, size_t... Hot>
+    struct hinted_dispatcher;
+
+    template <typename R, size_t N, typename Caller>
+    struct hinted_dispatcher<R, N, Caller> : public dispatcher<R, N, Caller>
+    {
+    };
+
+    template <typename R, size_t N, typename Caller, size_t H,
+      size_t... Hot>
+    struct hinted_dispatcher<R, N, Caller, H, Hot...>
+    {
+      static_assert(H < N, "a likely alternative is not in the variant");
+
+      template <typename... Args>
+      static constexpr R
+      dispatch(size_t which, Args&&... args)
+      {
+        if (JUICE_LIKELY(which == H))
+        {
+          return Caller::template call<H>(std::forward<Args>(args)...);
+        }
+
+        return hinted_dispatcher<R, N, Caller, Hot...>::dispatch(which,
+          std::forward<Args>(args)...);
+      }
+    };
+  }
+
+  template <typename T>
+  struct ref
+  {
+    static_assert(std::is_reference<T>::value,
+      "Can only be used with references");
+    constexpr ref(T t)
+    : m_t(std::forward<T>(t))
+    {
+    }
+
+    constexpr operator T() const {
+      return static_cast<T>(m_t);
+    }
+
+    private:
+    T m_t;
+  };
+
+  template <typename T, bool = std::is_reference<T>::value>
+  struct ref_type;
+
+  template <typename T>
+  struct ref_type<T, true>
+  {
+    typedef ref<T> type;
+  };
+
+  template <typename T>
+  struct ref_type<T, false>
   {
     typedef T type;
   };
@@ -423,260 +1127,1244 @@ namespace juice
   template <typename T>
   using ref_type_t = typename ref_type<T>::type;
 
+  //Whether a T can be moved to another address by copying its bytes and
+  //then forgetting the original, without running its move constructor and
+  //destructor. It holds for trivially copyable types, and can be
+  //specialised for types that are only moved by changing who owns a
+  //pointer, which excludes types that point into themselves, such as a
+  //std::string with a small string buffer in libstdc++.
+  template <typename T>
+  struct is_trivially_relocatable
+    : public std::integral_constant<bool,
+        std::is_trivially_copyable<T>::value>
+  {
+  };
+
+  template <typename T>
+  struct is_trivially_relocatable<const T>
+    : public is_trivially_relocatable<T>
+  {
+  };
+
+  template <typename T>
+  struct is_trivially_relocatable<ref<T>> : public std::true_type
+  {
+  };
+
+  template <typename T, typename U>
+  struct is_trivially_relocatable<std::pair<T, U>>
+    : public std::integral_constant<bool,
+        is_trivially_relocatable<T>::value &&
+        is_trivially_relocatable<U>::value>
+  {
+  };
+
+  template <typename T, typename Allocator>
+  struct is_trivially_relocatable<recursive_wrapper<T, Allocator>>
+    : public is_trivially_relocatable<
+        typename recursive_wrapper<T, Allocator>::allocator_type>
+  {
+  };
+
+  template <typename T>
+  struct is_trivially_relocatable<std::allocator<T>> : public std::true_type
+  {
+  };
+
+  template <typename T>
+  struct is_trivially_relocatable<std::unique_ptr<T>>
+    : public std::true_type
+  {
+  };
+
+  template <typename T>
+  struct is_trivially_relocatable<std::shared_ptr<T>>
+    : public std::true_type
+  {
+  };
+
+  //a variant is trivially relocatable when all of its alternatives are, its
+  //index is relocated with the bytes of the value
   template <typename... Types>
-  class variant
+  struct is_trivially_relocatable<variant<Types...>>
+    : public std::integral_constant<bool, conjunction<
+        is_trivially_relocatable<ref_type_t<Types>>::value...
+      >::value>
   {
-    private:
+  };
 
-    typedef typename detail::pack_first<Types...>::type First;
+  namespace detail
+  {
+    template <typename T>
+    void
+    relocate(T* first, T* last, T* out, std::true_type) noexcept
+    {
+      if (first != last)
+      {
+        std::memcpy(static_cast<void*>(out), static_cast<const void*>(first),
+          (last - first) * sizeof(T));
+      }
+    }
 
-    template <typename... AllTypes>
-    struct do_visit
+    template <typename T>
+    void
+    relocate(T* first, T* last, T* out, std::false_type)
+      noexcept(std::is_nothrow_move_constructible<T>::value)
     {
-      template 
-      <
-        typename Internal, 
-        typename VoidPtrCV, 
-        typename Visitor, 
-        typename... Args
-      >
-      decltype(auto)
-      operator()
-      (
-        Internal&& internal,
-        size_t which, 
-        VoidPtrCV&& storage, 
-        Visitor&& visitor,
-        Args&&... args
-      )
+      for (; first != last; ++first, ++out)
       {
-        typedef
-        typename std::common_type<
-          decltype (visitor_caller<Internal&&, AllTypes, VoidPtrCV&&, Visitor,
-            Args&&...>
-            (
-              std::forward<Internal>(internal),
-              std::forward<VoidPtrCV>(storage), 
-              std::forward<Visitor>(visitor), 
-              std::forward<Args>(args)...
-            ))...
-        >::type
-        result;
+        ::new (static_cast<void*>(out)) T(std::move(*first));
+        first->~T();
+      }
+    }
+  }
 
-        typedef result
-          (*whichCaller)(Internal&&, VoidPtrCV&&, Visitor&&, Args&&...);
+  //Moves the objects in [first, last) to the uninitialised memory at out,
+  //which must not overlap them, and ends their lifetimes. They are copied
+  //as bytes when T is trivially relocatable.
+  template <typename T>
+  void
+  relocate(T* first, T* last, T* out)
+    noexcept(is_trivially_relocatable<T>::value ||
+      std::is_nothrow_move_constructible<T>::value)
+  {
+    detail::relocate(first, last, out, std::integral_constant<bool,
+      is_trivially_relocatable<T>::value>());
+  }
 
-        static whichCaller callers[sizeof...(AllTypes)] =
-          {
-            &visitor_caller<Internal&&, AllTypes,
-              VoidPtrCV&&, Visitor, Args&&...>...
-          }
-        ;
+  namespace detail
+  {
+    template <typename T>
+    constexpr T
+    get_value(ref<T>& r, const MPL::false_&)
+    {
+      return r;
+    }
+
+    template <typename T>
+    constexpr T
+    get_value(const ref<T>& r, const MPL::false_&)
+    {
+      return r;
+    }
+
+    template <typename T>
+    constexpr T
+    get_value(ref<T>&& r, const MPL::false_&)
+    {
+      return r;
+    }
 
-        assert(which >= 0 && which < sizeof...(AllTypes));
+    //The storage of the alternatives of a variant. Unlike aligned storage
+    //accessed through reinterpret_cast, a union can be initialised and read
+    //in a constant expression. A union of trivially destructible types keeps
+    //its trivial destructor, so that the variant can be a literal type,
+    //otherwise the variant destroys the alternative itself.
+    template <bool TrivialDestructor, typename... Types>
+    union variant_union
+    {
+    };
 
-        return (*callers[which])
-          (
-            std::forward<Internal>(internal),
-            std::forward<VoidPtrCV>(storage), 
-            std::forward<Visitor>(visitor), 
-            std::forward<Args>(args)...
-          );
+    template <typename First, typename... Rest>
+    union variant_union<true, First, Rest...>
+    {
+      variant_union() {}
+
+      template <typename... Args>
+      constexpr variant_union(emplaced_index_t<0>, Args&&... args)
+      : m_head(std::forward<Args>(args)...)
+      {
+      }
+
+      template <size_t I, typename... Args>
+      constexpr variant_union(emplaced_index_t<I>, Args&&... args)
+      : m_tail(emplaced_index_t<I - 1>(), std::forward<Args>(args)...)
+      {
       }
+
+      First m_head;
+      variant_union<true, Rest...> m_tail;
     };
 
+    template <typename First, typename... Rest>
+    union variant_union<false, First, Rest...>
+    {
+      variant_union() {}
+
+      template <typename... Args>
+      constexpr variant_union(emplaced_index_t<0>, Args&&... args)
+      : m_head(std::forward<Args>(args)...)
+      {
+      }
+
+      template <size_t I, typename... Args>
+      constexpr variant_union(emplaced_index_t<I>, Args&&... args)
+      : m_tail(emplaced_index_t<I - 1>(), std::forward<Args>(args)...)
+      {
+      }
+
+      ~variant_union() {}
+
+      First m_head;
+      variant_union<false, Rest...> m_tail;
+    };
+
+    template <typename... Types>
+    using variant_union_t = variant_union
+    <
+      conjunction<
+        std::is_trivially_destructible<ref_type_t<Types>>::value...
+      >::value,
+      ref_type_t<Types>...
+    >;
+
+    //the I'th member of a variant_union
+    struct union_access
+    {
+      template <typename Union>
+      static constexpr auto&
+      get(emplaced_index_t<0>, Union& u)
+      {
+        return u.m_head;
+      }
+
+      template <size_t I, typename Union>
+      static constexpr auto&
+      get(emplaced_index_t<I>, Union& u)
+      {
+        return get(emplaced_index_t<I - 1>(), u.m_tail);
+      }
+
+      template <size_t I, typename Union>
+      static constexpr auto&
+      get(Union& u)
+      {
+        return get(emplaced_index_t<I>(), u);
+      }
+    };
+
+    //swaps the I'th alternatives of two variants that both hold it
+    struct swap_caller
+    {
+      template <size_t I, typename Storage>
+      static void
+      call(Storage& a, Storage& b)
+      {
+        swap_values(union_access::get<I>(a), union_access::get<I>(b),
+          std::is_move_assignable<std::decay_t<decltype(
+            union_access::get<I>(a))>>());
+      }
+
+      template <typename T>
+      static void
+      swap_values(T& a, T& b, std::true_type)
+      {
+        using std::swap;
+        swap(a, b);
+      }
+
+      //types that can't be assigned, such as ref, are constructed again
+      template <typename T>
+      static void
+      swap_values(T& a, T& b, std::false_type)
+      {
+        T tmp(std::move(a));
+        a.~T();
+        ::new (static_cast<void*>(&a)) T(std::move(b));
+        b.~T();
+        ::new (static_cast<void*>(&b)) T(std::move(tmp));
+      }
+    };
+
+    //calls the visitor with the I'th alternative in the storage
+    template <typename R, typename Internal>
+    struct alternative_caller
+    {
+      template <size_t I, typename Storage, typename Visitor,
+        typename... Args>
+      static constexpr decltype(auto)
+      invoke(Storage&& storage, Visitor&& visitor, Args&&... args)
+      {
+        return visitor(get_value(union_access::get<I>(storage), Internal()),
+          std::forward<Args>(args)...);
+      }
+
+      template <size_t I, typename Storage, typename Visitor,
+        typename... Args>
+      static constexpr R
+      call(Storage&& storage, Visitor&& visitor, Args&&... args)
+      {
+        return invoke<I>(std::forward<Storage>(storage),
+          std::forward<Visitor>(visitor), std::forward<Args>(args)...);
+      }
+    };
+  }
+
+  //Describes the bit patterns of T that never hold a valid T. A variant
+  //where every alternative but one is empty, such as
+  //variant<monostate, T*>, keeps its index in these patterns of the one
+  //alternative instead of storing an index beside it.
+  //A specialisation has count spare patterns numbered from zero:
+  //  set(p, n) writes pattern n into the storage p of a T that is not alive,
+  //  get(p) returns the pattern stored in p, or count if p holds a T.
+  template <typename T, typename = void>
+  struct niche_traits
+  {
+    static constexpr size_t count = 0;
+  };
+
+  template <>
+  struct niche_traits<bool>
+  {
+    //only 0 and 1 are used
+    static constexpr size_t count = 254;
+
+    static void
+    set(void* p, size_t n)
+    {
+      unsigned char c = static_cast<unsigned char>(n + 2);
+      std::memcpy(p, &c, 1);
+    }
+
+    static size_t
+    get(const void* p)
+    {
+      unsigned char c;
+      std::memcpy(&c, p, 1);
+      return c > 1 ? c - 2 : count;
+    }
+  };
+
+  //Pointers never point into the first page of memory on the platforms
+  //supported, so its addresses are spare. A null pointer is a valid value.
+  template <typename T>
+  struct niche_traits<T*>
+  {
+    static constexpr size_t count = 255;
+
+    static void
+    set(void* p, size_t n)
+    {
+      std::uintptr_t address = n + 1;
+      std::memcpy(p, &address, sizeof(address));
+    }
+
+    static size_t
+    get(const void* p)
+    {
+      std::uintptr_t address;
+      std::memcpy(&address, p, sizeof(address));
+      return address - 1 < count ? address - 1 : count;
+    }
+  };
+
+  //a ref can't be null either
+  template <typename T>
+  struct niche_traits<ref<T>>
+  {
+    static_assert(sizeof(ref<T>) == sizeof(std::uintptr_t),
+      "ref is expected to be a pointer");
+
+    static constexpr size_t count = 256;
+
+    static void
+    set(void* p, size_t n)
+    {
+      std::uintptr_t address = n;
+      std::memcpy(p, &address, sizeof(address));
+    }
+
+    static size_t
+    get(const void* p)
+    {
+      std::uintptr_t address;
+      std::memcpy(&address, p, sizeof(address));
+      return address < count ? address : count;
+    }
+  };
+
+  //Niches for an enum whose values are all in [First, Last]. Specialise
+  //niche_traits for the enum and inherit from this, for example
+  //  template <> struct niche_traits<Colour>
+  //  : enum_niche_traits<Colour, Colour::red, Colour::blue> {};
+  template <typename E, E First, E Last>
+  struct enum_niche_traits
+  {
+    private:
+    typedef std::underlying_type_t<E> underlying;
+
+    static constexpr underlying m_last = static_cast<underlying>(Last);
+
+    static constexpr size_t m_above =
+      static_cast<std::make_unsigned_t<underlying>>(
+        std::numeric_limits<underlying>::max() - m_last);
+
+    public:
+    static_assert(static_cast<underlying>(First) <= m_last,
+      "enum range is empty");
+
+    static constexpr size_t count = m_above < 256 ? m_above : 256;
+
+    static void
+    set(void* p, size_t n)
+    {
+      underlying u = static_cast<underlying>(m_last + 1 + n);
+      std::memcpy(p, &u, sizeof(u));
+    }
+
+    static size_t
+    get(const void* p)
+    {
+      underlying u;
+      std::memcpy(&u, p, sizeof(u));
+      if (u > m_last && static_cast<size_t>(u - m_last - 1) < count)
+      {
+        return u - m_last - 1;
+      }
+      return count;
+    }
+  };
+
+  namespace detail
+  {
     template <typename T>
-    struct Sizeof
+    struct stored_size
     {
-      static constexpr size_t value = sizeof(T);
+      static constexpr size_t value = sizeof(ref_type_t<T>);
     };
 
     template <typename T>
-    struct Alignof
+    struct stored_align
     {
-      static constexpr size_t value = alignof(T);
+      static constexpr size_t value = alignof(ref_type_t<T>);
     };
 
-    //size = max of size of each thing
-    static constexpr size_t m_size = 
-      max
+    //The index of the only alternative that isn't empty, or
+    //tuple_not_found if there isn't exactly one.
+    template <typename... Types>
+    constexpr size_t
+    only_dataful()
+    {
+      constexpr bool empty[] = {std::is_empty<ref_type_t<Types>>::value...};
+      size_t found = tuple_not_found;
+      for (size_t i = 0; i != sizeof...(Types); ++i)
+      {
+        if (!empty[i])
+        {
+          if (found != tuple_not_found)
+          {
+            return tuple_not_found;
+          }
+          found = i;
+        }
+      }
+      return found;
+    }
+
+    template <bool Candidate, size_t D, typename... Types>
+    struct niche_usable : public std::false_type
+    {
+      typedef void type;
+    };
+
+    template <size_t D, typename... Types>
+    struct niche_usable<true, D, Types...>
+    {
+      typedef ref_type_t<std::tuple_element_t<D, std::tuple<Types...>>> type;
+
+      //one pattern for each other alternative and one for valueless
+      static constexpr bool value =
+        niche_traits<type>::count >= sizeof...(Types) &&
+        std::is_trivially_copyable<type>::value;
+    };
+
+    template <typename... Types>
+    struct niche_layout
+    {
+      static constexpr size_t dataful = only_dataful<Types...>();
+
+      typedef niche_usable
       <
-        Sizeof,
+        dataful != tuple_not_found,
+        dataful,
         Types...
-      >::value;
+      > usable;
+
+      static constexpr bool value = usable::value;
+
+      typedef typename usable::type type;
+    };
+
+    template <bool Niche, typename... Types>
+    class variant_storage;
+
+    //the index is stored after the storage
+    template <typename... Types>
+    class variant_storage<false, Types...>
+    {
+      protected:
+      variant_storage() = default;
+
+      template <size_t I, typename... Args>
+      constexpr variant_storage(emplaced_index_t<I>, Args&&... args)
+      : m_storage(emplaced_index_t<I>(), std::forward<Args>(args)...)
+      , m_which(static_cast<variant_index_t<sizeof...(Types)>>(I))
+      {
+      }
+
+      variant_union_t<Types...> m_storage;
+
+      //the smallest type that holds the index, placed after the storage so
+      //that it only adds the padding needed to align the whole variant
+      variant_index_t<sizeof...(Types)> m_which;
+
+      constexpr size_t
+      load_index() const
+      {
+        //the sign extension turns the valueless -1 into tuple_not_found
+        return static_cast<size_t>(m_which);
+      }
+
+      void
+      store_index(size_t which)
+      {
+        m_which = static_cast<variant_index_t<sizeof...(Types)>>(which);
+      }
+    };
+
+    //The index is stored in the spare patterns of the only alternative that
+    //isn't empty. The empty alternatives live at the same address, they
+    //have no bytes that the pattern could overwrite.
+    template <typename... Types>
+    class variant_storage<true, Types...>
+    {
+      typedef niche_layout<Types...> layout;
+      typedef niche_traits<typename layout::type> traits;
+
+      static constexpr size_t dataful = layout::dataful;
+
+      protected:
+      variant_storage() = default;
+
+      //This can't be used in a constant expression, the index is written
+      //over the bytes of the storage.
+      template <size_t I, typename... Args>
+      variant_storage(emplaced_index_t<I>, Args&&... args)
+      : m_storage(emplaced_index_t<I>(), std::forward<Args>(args)...)
+      {
+        store_index(I);
+      }
+
+      //the empty alternatives don't make the union any larger
+      variant_union_t<Types...> m_storage;
+
+      size_t
+      load_index() const
+      {
+        size_t n = traits::get(&m_storage);
+        if (n == traits::count)
+        {
+          return dataful;
+        }
+        else if (n == sizeof...(Types) - 1)
+        {
+          return tuple_not_found;
+        }
+        else
+        {
+          return n < dataful ? n : n + 1;
+        }
+      }
+
+      void
+      store_index(size_t which)
+      {
+        //the dataful alternative is its own index
+        if (which == tuple_not_found)
+        {
+          traits::set(&m_storage, sizeof...(Types) - 1);
+        }
+        else if (which != dataful)
+        {
+          traits::set(&m_storage, which < dataful ? which : which - 1);
+        }
+      }
+    };
+
+    template <typename... Types>
+    using variant_storage_t =
+      variant_storage<niche_layout<Types...>::value, Types...>;
+
+    //The storage of a variant and the operations on it, which the special
+    //members below are built from.
+    template <typename... Types>
+    class variant_base : public variant_storage_t<Types...>
+    {
+      protected:
+      typedef variant_storage_t<Types...> storage;
+      using storage::storage;
+      using storage::m_storage;
+
+      variant_base() = default;
+
+      //Uses-allocator copy and move of rhs. The alternative is in place
+      //when the constructor of a derived class runs, and until then this is
+      //valueless.
+      template <typename Alloc>
+      variant_base(std::allocator_arg_t, const Alloc& a,
+        const variant_base& rhs)
+      {
+        indicate_which(tuple_not_found);
+        if (!rhs.valueless())
+        {
+          rhs.apply_visitor_internal(allocator_constructor<Alloc>(*this, a));
+        }
+        indicate_which(rhs.index());
+      }
+
+      template <typename Alloc>
+      variant_base(std::allocator_arg_t, const Alloc& a, variant_base&& rhs)
+      {
+        indicate_which(tuple_not_found);
+        if (!rhs.valueless())
+        {
+          rhs.apply_visitor_internal(
+            allocator_move_constructor<Alloc>(*this, a));
+        }
+        indicate_which(rhs.index());
+      }
+
+      template 
+      <
+        typename Internal, 
+        typename Storage, 
+        typename Visitor, 
+        typename... Args
+      >
+      static constexpr decltype(auto)
+      do_visit(size_t which, Storage& storage, Visitor&& visitor,
+        Args&&... args)
+      {
+        typedef typename multi_result
+        <
+          alternative_caller<void, Internal>,
+          std::index_sequence_for<Types...>,
+          Storage&,
+          Visitor,
+          Args&&...
+        >::type result;
+
+        assert(which < sizeof...(Types));
+
+        return detail::dispatcher
+        <
+          result,
+          sizeof...(Types),
+          detail::alternative_caller<result, Internal>
+        >::dispatch
+        (
+          which,
+          storage,
+          std::forward<Visitor>(visitor),
+          std::forward<Args>(args)...
+        );
+      }
+
+      struct constructor
+      {
+        constructor(variant_base& self)
+        : m_self(self)
+        {
+        }
+
+        void
+        operator()() const
+        {
+          //don't do anything if the rhs is empty
+        }
+
+        template <typename T>
+        void
+        operator()(const T& rhs) const
+        {
+          m_self.construct<T>(rhs);
+        }
+
+        private:
+        variant_base& m_self;
+      };
+
+      struct move_constructor
+      {
+        move_constructor(variant_base& self)
+        : m_self(self)
+        {
+        }
+
+        void
+        operator()() const
+        {
+        }
+
+        template <typename T>
+        void
+        operator()(T& rhs) const
+        {
+          m_self.construct<T>(std::move(rhs));
+        }
+
+        private:
+        variant_base& m_self;
+      };
+
+      //constructs the alternative from rhs with uses-allocator construction
+      template <typename Alloc>
+      struct allocator_constructor
+      {
+        allocator_constructor(variant_base& self, const Alloc& a)
+        : m_self(self), m_alloc(a)
+        {
+        }
+
+        template <typename T>
+        void
+        operator()(const T& rhs) const
+        {
+          construct_with_allocator<T>(
+            allocator_construction_t<T, Alloc, const T&>(),
+            m_self.address(), m_alloc, rhs);
+        }
+
+        private:
+        variant_base& m_self;
+        const Alloc& m_alloc;
+      };
+
+      template <typename Alloc>
+      struct allocator_move_constructor
+      {
+        allocator_move_constructor(variant_base& self, const Alloc& a)
+        : m_self(self), m_alloc(a)
+        {
+        }
+
+        template <typename T>
+        void
+        operator()(T& rhs) const
+        {
+          construct_with_allocator<T>(
+            allocator_construction_t<T, Alloc, T&&>(),
+            m_self.address(), m_alloc, std::move(rhs));
+        }
+
+        private:
+        variant_base& m_self;
+        const Alloc& m_alloc;
+      };
+
+      //Destroys the held value to make way for another, without a dispatch
+      //when none of the alternatives need destroying.
+      void
+      discard()
+      {
+        if (conjunction<
+              std::is_trivially_destructible<ref_type_t<Types>>::value...
+            >::value)
+        {
+          indicate_which(tuple_not_found);
+        }
+        else
+        {
+          destroy();
+        }
+      }
+
+      //Replaces the value with rhs of the same type. Types that can't be
+      //assigned, such as ref, are destroyed and constructed again.
+      template <typename T, typename U>
+      void
+      reassign(T& lhs, U&& rhs, std::true_type)
+      {
+        lhs = std::forward<U>(rhs);
+      }
+
+      template <typename T, typename U>
+      void
+      reassign(T& lhs, U&& rhs, std::false_type)
+      {
+        size_t which = index();
+        lhs.~T();
+        indicate_which(tuple_not_found);
+        construct<T>(std::forward<U>(rhs));
+        indicate_which(which);
+      }
+
+      //Copies rhs into the storage directly when that can't throw, and
+      //otherwise through a temporary so that a throwing copy leaves the
+      //held value alone.
+      template <typename T>
+      void
+      replace(const T& rhs, std::true_type)
+      {
+        discard();
+        construct<T>(rhs);
+      }
+
+      template <typename T>
+      void
+      replace(const T& rhs, std::false_type)
+      {
+        T tmp(rhs);
+        discard();
+
+        //if this throws, then we are already empty
+        construct<T>(std::move(tmp));
+      }
+
+      //Assigns the R'th alternative of rhs, either into the held value when
+      //it is the same alternative, or in place of it.
+      template <size_t R>
+      void
+      assign_alternative(const variant_base& rhs)
+      {
+        auto& value = union_access::get<R>(rhs.m_storage);
+        typedef std::decay_t<decltype(value)> T;
+
+        if (index() == R)
+        {
+          reassign(union_access::get<R>(m_storage), value,
+            std::is_copy_assignable<T>());
+        }
+        else
+        {
+          replace(value, std::is_nothrow_copy_constructible<T>());
+        }
+      }
+
+      template <size_t R>
+      void
+      assign_alternative(variant_base&& rhs)
+      {
+        auto& value = union_access::get<R>(rhs.m_storage);
+        typedef std::decay_t<decltype(value)> T;
+
+        if (index() == R)
+        {
+          reassign(union_access::get<R>(m_storage), std::move(value),
+            std::is_move_assignable<T>());
+        }
+        else
+        {
+          //the standard proposal does not guard against rhs being in a
+          //subtree of this, and neither do we
+          discard();
+          construct<T>(std::move(value));
+        }
+      }
+
+      struct assign_caller
+      {
+        template <size_t R, typename Rhs>
+        static void
+        call(variant_base& self, Rhs&& rhs)
+        {
+          self.template assign_alternative<R>(std::forward<Rhs>(rhs));
+        }
+      };
+
+      //Assigns rhs, which holds a value, with one dispatch on its index.
+      //The held value is destroyed with a second only when it is a
+      //different alternative that isn't trivially destructible.
+      template <typename Rhs>
+      void
+      assign_from(Rhs&& rhs)
+      {
+        size_t r = rhs.index();
+        assert(r < sizeof...(Types));
+
+        dispatcher<void, sizeof...(Types), assign_caller>::dispatch(r, *this,
+          std::forward<Rhs>(rhs));
+        indicate_which(r);
+      }
+
+      struct destroyer
+      {
+        void
+        operator()() const
+        {
+          //do nothing when empty
+        }
+
+        template <typename T>
+        void
+        operator()(T& t) const
+        {
+          t.~T();
+        }
+      };
 
-    struct constructor
-    {
-      constructor(variant& self)
-      : m_self(self)
+      constexpr size_t index() const { return this->load_index(); }
+
+      constexpr bool valueless() const { return index() == tuple_not_found; }
+
+      template <typename Internal, typename Visitor, typename... Args>
+      constexpr decltype(auto)
+      visit_storage(Visitor&& visitor, Args&&... args)
       {
+        return do_visit<Internal>(index(), m_storage,
+          std::forward<Visitor>(visitor), std::forward<Args>(args)...);
       }
 
-      void
-      operator()() const
+      template <typename Internal, typename Visitor, typename... Args>
+      constexpr decltype(auto)
+      visit_storage(Visitor&& visitor, Args&&... args) const
       {
-        //don't do anything if the rhs is empty
+        return do_visit<Internal>(index(), m_storage,
+          std::forward<Visitor>(visitor), std::forward<Args>(args)...);
       }
 
-      template <typename T>
-      void
-      operator()(const T& rhs) const
+      void indicate_which(size_t which) {this->store_index(which);}
+
+      void* address() {return &m_storage;}
+      const void* address() const {return &m_storage;}
+
+      template <typename Visitor>
+      decltype(auto)
+      apply_visitor_internal(Visitor&& visitor)
       {
-        m_self.construct<T>(rhs);
+        return visit_storage<MPL::true_>(std::forward<Visitor>(visitor));
       }
 
-      private:
-      variant& m_self;
-    };
+      template <typename Visitor>
+      decltype(auto)
+      apply_visitor_internal(Visitor&& visitor) const
+      {
+        return visit_storage<MPL::true_>(std::forward<Visitor>(visitor));
+      }
 
-    struct move_constructor
-    {
-      move_constructor(variant& self)
-      : m_self(self)
+      void
+      destroy()
       {
+        //shortcut here to bypass calling the empty destroy function
+        if (index() != tuple_not_found)
+        {
+          apply_visitor_internal(destroyer());
+          indicate_which(tuple_not_found);
+        }
       }
 
+      template <typename T, typename... Args>
+      constexpr
       void
-      operator()() const
+      emplace_internal(Args&&... args)
       {
+        new(&m_storage) T(std::forward<Args>(args)...);
       }
 
-      template <typename T>
+      template <typename T, typename U>
+      constexpr
       void
-      operator()(T& rhs) const
+      construct(U&& t)
       {
-        m_self.construct<T>(std::move(rhs));
+        using R = typename std::conditional<std::is_reference<T>::value, 
+          ref<T>, T>::type;
+        new(&m_storage) R(std::forward<U>(t));
       }
+    };
 
-      private:
-      variant& m_self;
+
+    //Which of the special members of every alternative are trivial. The
+    //special members of the variant are trivial exactly when they are, so
+    //for example a vector of trivially copyable variants can be copied with
+    //memcpy.
+    template <typename... Types>
+    struct variant_triviality
+    {
+      static constexpr bool destructor = conjunction<
+        std::is_trivially_destructible<ref_type_t<Types>>::value...
+      >::value;
+
+      static constexpr bool copy_constructor = destructor && conjunction<
+        std::is_trivially_copy_constructible<ref_type_t<Types>>::value...
+      >::value;
+
+      static constexpr bool move_constructor = destructor && conjunction<
+        std::is_trivially_move_constructible<ref_type_t<Types>>::value...
+      >::value;
+
+      static constexpr bool copy_assignment = copy_constructor &&
+        conjunction<
+          std::is_trivially_copy_assignable<ref_type_t<Types>>::value...
+        >::value;
+
+      static constexpr bool move_assignment = move_constructor &&
+        conjunction<
+          std::is_trivially_move_assignable<ref_type_t<Types>>::value...
+        >::value;
     };
 
-    struct assigner
+    template <bool Trivial, typename... Types>
+    class variant_destructor : public variant_base<Types...>
     {
-      assigner(variant& self, int rhs_which)
-      : m_self(self), m_rhs_which(rhs_which)
-      {
-      }
+      typedef variant_base<Types...> base;
 
-      void
-      operator()()
+      public:
+      using base::base;
+    };
+
+    template <typename... Types>
+    class variant_destructor<false, Types...> : public variant_base<Types...>
+    {
+      typedef variant_base<Types...> base;
+
+      public:
+      using base::base;
+
+      variant_destructor() = default;
+      variant_destructor(const variant_destructor&) = default;
+      variant_destructor(variant_destructor&&) = default;
+
+      variant_destructor&
+      operator=(const variant_destructor&) = default;
+
+      variant_destructor&
+      operator=(variant_destructor&&) = default;
+
+      ~variant_destructor()
       {
-        //if the right-hand side is empty then we need to
-        //destroy the lhs
-        m_self.destroy();
+        this->destroy();
       }
+    };
 
-      template <typename Rhs>
-      void
-      operator()(const Rhs& rhs) const
+    template <typename... Types>
+    using variant_destructor_t = variant_destructor
+    <
+      variant_triviality<Types...>::destructor,
+      Types...
+    >;
+
+    template <bool Trivial, typename... Types>
+    class variant_copy_constructor : public variant_destructor_t<Types...>
+    {
+      typedef variant_destructor_t<Types...> base;
+
+      public:
+      using base::base;
+    };
+
+    template <typename... Types>
+    class variant_copy_constructor<false, Types...>
+      : public variant_destructor_t<Types...>
+    {
+      typedef variant_destructor_t<Types...> base;
+
+      public:
+      using base::base;
+
+      variant_copy_constructor() = default;
+
+      variant_copy_constructor(const variant_copy_constructor& rhs)
       {
-        if (m_self.which() == m_rhs_which)
+        if (!rhs.valueless())
         {
-          //the types are the same, so just assign into the lhs
-          *reinterpret_cast<Rhs*>(m_self.address()) = rhs;
-        }
-        else
-        {
-          Rhs tmp(rhs);
-          m_self.destroy();
-
-          //if this throws, then we are already empty
-          m_self.construct<Rhs>(std::move(tmp));
+          rhs.apply_visitor_internal(typename base::constructor(*this));
         }
+        this->indicate_which(rhs.index());
       }
 
-      private:
-      variant& m_self;
-      size_t m_rhs_which;
+      variant_copy_constructor(variant_copy_constructor&&) = default;
+
+      variant_copy_constructor&
+      operator=(const variant_copy_constructor&) = default;
+
+      variant_copy_constructor&
+      operator=(variant_copy_constructor&&) = default;
     };
-    
-    struct move_assigner
+
+    template <typename... Types>
+    using variant_copy_constructor_t = variant_copy_constructor
+    <
+      variant_triviality<Types...>::copy_constructor,
+      Types...
+    >;
+
+    template <bool Trivial, typename... Types>
+    class variant_move_constructor
+      : public variant_copy_constructor_t<Types...>
     {
-      move_assigner(variant& self, int rhs_which)
-      : m_self(self), m_rhs_which(rhs_which)
-      {
-      }
+      typedef variant_copy_constructor_t<Types...> base;
 
-      template <typename Rhs>
-      void
-      operator()(Rhs& rhs) const
+      public:
+      using base::base;
+    };
+
+    template <typename... Types>
+    class variant_move_constructor<false, Types...>
+      : public variant_copy_constructor_t<Types...>
+    {
+      typedef variant_copy_constructor_t<Types...> base;
+
+      public:
+      using base::base;
+
+      variant_move_constructor() = default;
+      variant_move_constructor(const variant_move_constructor&) = default;
+
+      variant_move_constructor(variant_move_constructor&& rhs)
+      noexcept(conjunction<std::is_nothrow_move_constructible<
+        ref_type_t<Types>
+      >::value...>::value)
       {
-        typedef typename std::remove_const<Rhs>::type RhsNoConst;
-        if (m_self.which() == m_rhs_which)
-        {
-          //the types are the same, so just assign into the lhs
-          *reinterpret_cast<RhsNoConst*>(m_self.address()) = std::move(rhs);
-        }
-        else
+        //this does not invalidate rhs, it moves the value in rhs to this,
+        //which leaves an empty but valid value in rhs
+        if (!rhs.valueless())
         {
-          //in case rhs is in a subtree of self, we don't want to destroy it
-          //first
-          //we can move self to a temporary object because rhs can only be
-          //the same type as self, which means that it is in a
-          //recursive_wrapper, and recursive_wrapper move assignment only
-          //copies its pointer
-
-          //if this throws we are ok because tmp will not exist and
-          //m_self will still be consistent
-          //variant tmp(std::move(m_self));
-
-          //now m_self is empty, if this throws then we are all good
-          //m_self.construct(std::move(rhs));
-
-          //the standard proposal does not do this because there are no
-          //recursive types, instead it just does:
-          m_self.destroy();
-          new (&m_self.m_storage) Rhs(std::move(rhs));
+          rhs.apply_visitor_internal(typename base::move_constructor(*this));
         }
+        this->indicate_which(rhs.index());
       }
 
-      private:
-      variant& m_self;
-      size_t m_rhs_which;
+      variant_move_constructor&
+      operator=(const variant_move_constructor&) = default;
+
+      variant_move_constructor&
+      operator=(variant_move_constructor&&) = default;
     };
 
-    struct equality
+    template <typename... Types>
+    using variant_move_constructor_t = variant_move_constructor
+    <
+      variant_triviality<Types...>::move_constructor,
+      Types...
+    >;
+
+    template <bool Trivial, typename... Types>
+    class variant_copy_assignment
+      : public variant_move_constructor_t<Types...>
     {
-      equality(const variant& self)
-      : m_self(self)
-      {
-      }
+      typedef variant_move_constructor_t<Types...> base;
 
-      bool
-      operator()() const
-      {
-        //not equal when something is empty
-        return false;
-      }
+      public:
+      using base::base;
+    };
 
-      template <typename Rhs>
-      bool
-      operator()(Rhs& rhs) const
+    template <typename... Types>
+    class variant_copy_assignment<false, Types...>
+      : public variant_move_constructor_t<Types...>
+    {
+      typedef variant_move_constructor_t<Types...> base;
+
+      public:
+      using base::base;
+
+      variant_copy_assignment() = default;
+      variant_copy_assignment(const variant_copy_assignment&) = default;
+      variant_copy_assignment(variant_copy_assignment&&) = default;
+
+      variant_copy_assignment&
+      operator=(const variant_copy_assignment& rhs)
       {
-        return *reinterpret_cast<Rhs*>(m_self.address()) == rhs;
+        if (this != &rhs)
+        {
+          if (rhs.valueless())
+          {
+            this->destroy();
+          }
+          else
+          {
+            this->assign_from(rhs);
+          }
+        }
+        return *this;
       }
 
-      private:
-      const variant& m_self;
+      variant_copy_assignment&
+      operator=(variant_copy_assignment&&) = default;
     };
 
-    struct destroyer
+    template <typename... Types>
+    using variant_copy_assignment_t = variant_copy_assignment
+    <
+      variant_triviality<Types...>::copy_assignment,
+      Types...
+    >;
+
+    template <bool Trivial, typename... Types>
+    class variant_move_assignment
+      : public variant_copy_assignment_t<Types...>
     {
-      void
-      operator()() const
-      {
-        //do nothing when empty
-      }
+      typedef variant_copy_assignment_t<Types...> base;
 
-      template <typename T>
-      void
-      operator()(T& t) const
+      public:
+      using base::base;
+    };
+
+    template <typename... Types>
+    class variant_move_assignment<false, Types...>
+      : public variant_copy_assignment_t<Types...>
+    {
+      typedef variant_copy_assignment_t<Types...> base;
+
+      public:
+      using base::base;
+
+      variant_move_assignment() = default;
+      variant_move_assignment(const variant_move_assignment&) = default;
+      variant_move_assignment(variant_move_assignment&&) = default;
+
+      variant_move_assignment&
+      operator=(const variant_move_assignment&) = default;
+
+      variant_move_assignment&
+      operator=(variant_move_assignment&& rhs)
+      noexcept(
+        conjunction<(
+          std::is_nothrow_move_constructible<ref_type_t<Types>>::value &&
+          std::is_nothrow_move_assignable<ref_type_t<Types>>::value
+        )...
+        >::value
+      )
       {
-        t.~T();
+        if (this != &rhs)
+        {
+          if (rhs.valueless())
+          {
+            this->destroy();
+          }
+          else
+          {
+            this->assign_from(std::move(rhs));
+          }
+        }
+        return *this;
       }
     };
 
+    template <typename... Types>
+    using variant_move_assignment_t = variant_move_assignment
+    <
+      variant_triviality<Types...>::move_assignment,
+      Types...
+    >;
+  }
+
+  template <typename... Types>
+  class variant
+    : private detail::variant_move_assignment_t<Types...>
+    , private detail::variant_profiler<variant<Types...>>
+  {
+    private:
+
+    typedef detail::variant_move_assignment_t<Types...> base;
+
+    using base::m_storage;
+    using base::indicate_which;
+    using base::address;
+    using base::apply_visitor_internal;
+    using base::destroy;
+
+    typedef typename detail::pack_first<Types...>::type First;
+
     template <typename... MyTypes>
     struct assign_FUN
     {
@@ -692,37 +2380,41 @@ namespace juice
       FUN(Current);
     };
 
-    template <size_t Which, typename... MyTypes>
-    struct initialiser;
+    //the alternative that variant(T&&) constructs
+    template <typename T>
+    using converted_type = decltype(assign_FUN<Types...>::FUN(
+      std::declval<T>()));
 
-    template <size_t Which, typename Current, typename... MyTypes>
-    struct initialiser<Which, Current, MyTypes...> 
-      : public initialiser<Which+1, MyTypes...>
-    {
-      typedef initialiser<Which+1, MyTypes...> base;
-      using base::initialise;
+    //how the allocator is passed to the I'th alternative
+    template <size_t I, typename Alloc, typename... Args>
+    using allocation = detail::allocator_construction_t
+    <
+      ref_type_t<std::tuple_element_t<I, variant>>,
+      Alloc,
+      Args...
+    >;
 
-      static void 
-      initialise(variant& v, Current&& current)
-      {
-        v.construct<Current>(std::move(current));
-        v.indicate_which(Which);
-      }
+    template <size_t I, typename Alloc, typename... Args>
+    constexpr variant(detail::allocator_unused, emplaced_index_t<I>,
+      const Alloc&, Args&&... args)
+    : base(emplaced_index_t<I>(), std::forward<Args>(args)...)
+    {
+    }
 
-      static void
-      initialise(variant& v, const Current& current)
-      {
-        v.construct<Current>(current);
-        v.indicate_which(Which);
-      }
-    };
+    template <size_t I, typename Alloc, typename... Args>
+    constexpr variant(detail::allocator_leading, emplaced_index_t<I>,
+      const Alloc& a, Args&&... args)
+    : base(emplaced_index_t<I>(), std::allocator_arg, a,
+        std::forward<Args>(args)...)
+    {
+    }
 
-    template <size_t Which>
-    struct initialiser<Which>
+    template <size_t I, typename Alloc, typename... Args>
+    constexpr variant(detail::allocator_trailing, emplaced_index_t<I>,
+      const Alloc& a, Args&&... args)
+    : base(emplaced_index_t<I>(), std::forward<Args>(args)..., a)
     {
-      //this should never match
-      void initialise();
-    };
+    }
 
     template <typename Current>
     static
@@ -805,14 +2497,8 @@ namespace juice
     >
     constexpr
     variant() noexcept(std::is_nothrow_default_constructible<First>::value)
-    : m_which(0)
-    {
-      emplace_internal<First>();
-    }
-
-    ~variant()
+    : base(emplaced_index_t<0>())
     {
-      destroy();
     }
 
     //enable_if disables this function if we are constructing with a variant.
@@ -828,78 +2514,113 @@ namespace juice
           detail::variant_universal_check<std::decay_t<T>, Types...>::value
         >::type
     >
+    //compile error here means that T is not unambiguously convertible to
+    //any of the types in (First, Types...)
     constexpr variant(T&& t)
+    : base(emplaced_index_t<tuple_find_v<converted_type<T>, variant>>(),
+        std::forward<T>(t))
     {
        static_assert(
           !std::is_same<variant<Types...>&, T>::value,
           "why is variant(T&&) instantiated with a variant?");
+    }
 
-      //compile error here means that T is not unambiguously convertible to
-      //any of the types in (First, Types...)
-      //initialiser<0, Types...>::initialise(*this, std::forward<T>(t));
+    //the special members are trivial when those of all the Types are
+    variant(const variant&) = default;
+    variant(variant&&) = default;
 
-      typedef decltype(assign_FUN<Types...>::FUN(std::forward<T>(t))) type;
-      constexpr auto I = tuple_find_v<type, variant>;
+    template <typename T, typename... Args>
+    constexpr explicit variant(emplaced_type_t<T>, Args&&... args)
+    : base(emplaced_index_t<tuple_find<T, variant<Types...>>::value>(),
+        std::forward<Args>(args)...)
+    {
+    }
 
-      construct<type>(std::forward<T>(t));
-      indicate_which(I);
+    template <typename T, typename U, typename... Args>
+    constexpr explicit variant(emplaced_type_t<T>,
+      std::initializer_list<U> il,
+      Args&&... args)
+    : base(emplaced_index_t<tuple_find<T, variant<Types...>>::value>(),
+        il, std::forward<Args>(args)...)
+    {
+    }
+
+    template <size_t I, typename... Args>
+    constexpr explicit variant(emplaced_index_t<I>, Args&&... args)
+    : base(emplaced_index_t<I>(), std::forward<Args>(args)...)
+    {
     }
 
-    variant(const variant& rhs)
+    template <size_t I, typename U, typename... Args>
+    constexpr explicit variant(emplaced_index_t<I>,
+      std::initializer_list<U> il,
+      Args&&... args)
+    : base(emplaced_index_t<I>(), il, std::forward<Args>(args)...)
     {
-      rhs.apply_visitor_internal(constructor(*this));
-      indicate_which(rhs.which());
     }
 
-    variant(variant&& rhs)
-    noexcept(conjunction<std::is_nothrow_move_constructible<
-      Types
-    >::value...>::value)
+    //Uses-allocator construction. The allocator is passed on to the
+    //alternative if it uses one, such as a recursive_wrapper, so that a
+    //whole tree of recursive variants allocates from it.
+    template 
+    <
+      typename Alloc,
+      typename = typename std::enable_if<
+        std::is_default_constructible<First>::value
+      >::type
+    >
+    variant(std::allocator_arg_t, const Alloc& a)
+    : variant(allocation<0, Alloc>(), emplaced_index_t<0>(), a)
     {
-      //this does not invalidate rhs, it moves the value in rhs to this,
-      //which leaves an empty but valid value in rhs
-      rhs.apply_visitor_internal(move_constructor(*this));
-      indicate_which(rhs.which());
     }
 
-    template <typename T>
-    variant(const T& t)
+    template 
+    <
+      typename Alloc,
+      typename T, 
+      typename = 
+        typename std::enable_if
+        <
+          detail::variant_universal_check<std::decay_t<T>, Types...>::value
+        >::type
+    >
+    variant(std::allocator_arg_t, const Alloc& a, T&& t)
+    : variant(
+        allocation<tuple_find_v<converted_type<T>, variant>, Alloc, T&&>(),
+        emplaced_index_t<tuple_find_v<converted_type<T>, variant>>(),
+        a, std::forward<T>(t))
     {
-      initialiser<0, Types...>::initialise(*this, t);
     }
 
-    template <typename T, typename... Args>
-    explicit variant(emplaced_type_t<T>, Args&&... args)
+    template <typename Alloc, typename T, typename... Args>
+    variant(std::allocator_arg_t, const Alloc& a, emplaced_type_t<T>,
+      Args&&... args)
+    : variant(std::allocator_arg, a,
+        emplaced_index_t<tuple_find<T, variant<Types...>>::value>(),
+        std::forward<Args>(args)...)
     {
-      emplace_internal<T>(std::forward<Args>(args)...);
-      indicate_which(tuple_find<T, variant<Types...>>::value);
     }
 
-    template <typename T, typename U, typename... Args>
-    explicit variant(emplaced_type_t<T>,
-      std::initializer_list<U> il,
+    template <typename Alloc, size_t I, typename... Args>
+    variant(std::allocator_arg_t, const Alloc& a, emplaced_index_t<I>,
       Args&&... args)
+    : variant(allocation<I, Alloc, Args&&...>(), emplaced_index_t<I>(), a,
+        std::forward<Args>(args)...)
     {
-      emplace_internal<T>(il, std::forward<Args>(args)...);
-      indicate_which(tuple_find<T, variant<Types...>>::value);
     }
 
-    template <size_t I, typename... Args>
-    explicit variant(emplaced_index_t<I>, Args&&... args)
+    //the alternative is constructed by the base, so that it is in place
+    //when the profiler counts the construction
+    template <typename Alloc>
+    variant(std::allocator_arg_t, const Alloc& a, const variant& rhs)
+    : base(std::allocator_arg, a, static_cast<const base&>(rhs))
     {
-      emplace_internal<typename std::tuple_element<I, variant>::type>(
-        std::forward<Args>(args)...);
-      indicate_which(I);
     }
 
-    template <size_t I, typename U, typename... Args>
-    explicit variant(emplaced_index_t<I>,
-      std::initializer_list<U> il,
-      Args&&... args)
+    template <typename Alloc>
+    variant(std::allocator_arg_t, const Alloc& a, variant&& rhs)
+    : base(std::allocator_arg, a, static_cast<base&&>(rhs))
     {
-      emplace_internal<typename std::tuple_element<I, variant>::type>(
-        il, std::forward<Args>(args)...);
-      indicate_which(I);
     }
 
     template <typename T, typename... Args>
@@ -920,63 +2641,24 @@ namespace juice
     template <size_t I, typename... Args>
     void emplace(Args&&... args)
     {
-      if (!valueless_by_exception())
-      {
-        destroy();
-      }
-      emplace_internal<typename std::tuple_element<I, variant>::type>(std::forward<Args>(args)...);
-      indicate_which(I);
-    }
-
-    template <size_t I, typename U, typename... Args>
-    void emplace(std::initializer_list<U> il, Args&&... args)
-    {
-      if (!valueless_by_exception())
-      {
-        destroy();
-      }
-      emplace_internal<typename std::tuple_element<I, variant>::type>(il, std::forward<Args>(args)...);
+      this->discard();
+      this->template emplace_internal<typename std::tuple_element<I, variant>::type>(std::forward<Args>(args)...);
       indicate_which(I);
+      JUICE_VARIANT_COUNT(construction, variant, I);
     }
-
-    variant& operator=(const variant& rhs)
-    {
-      if (this != &rhs)
-      {
-        rhs.apply_visitor_internal(assigner(*this, rhs.which()));
-        indicate_which(rhs.which());
-      }
-      return *this;
-    }
-
-    variant& operator=(variant&& rhs) 
-    noexcept(
-      conjunction<(
-        std::is_nothrow_move_constructible<Types>::value &&
-        std::is_nothrow_move_assignable<Types>::value
-      )...
-      >::value
-    )
-    {
-      if (this != &rhs)
-      {
-        auto w = rhs.which();
-        if (w == tuple_not_found)
-        {
-          if (index() != tuple_not_found)
-          {
-            destroy();
-          }
-        }
-        else
-        {
-          rhs.apply_visitor_internal(move_assigner(*this, w));
-          indicate_which(w);
-        }
-      }
-      return *this;
+
+    template <size_t I, typename U, typename... Args>
+    void emplace(std::initializer_list<U> il, Args&&... args)
+    {
+      this->discard();
+      this->template emplace_internal<typename std::tuple_element<I, variant>::type>(il, std::forward<Args>(args)...);
+      indicate_which(I);
+      JUICE_VARIANT_COUNT(construction, variant, I);
     }
 
+    variant& operator=(const variant&) = default;
+    variant& operator=(variant&&) = default;
+
 #if 0
     template <typename T>
     variant&
@@ -1006,45 +2688,53 @@ namespace juice
 
       if (index() != I)
       {
-        destroy();
+        this->discard();
         new (&m_storage) type(std::forward<T>(t));
       }
       else
       {
-        reinterpret_cast<type&>(m_storage) = std::forward<T>(t);
+        detail::union_access::get<I>(m_storage) = std::forward<T>(t);
       }
 
       indicate_which(I);
+      JUICE_VARIANT_COUNT(assignment, variant, I);
 
       return *this;
     }
 
-    bool
+    constexpr bool
     operator==(const variant& rhs) const
     {
-      if (which() != rhs.which())
+      if (index() != rhs.index())
       {
         return false;
       }
 
-      return rhs.apply_visitor_internal(equality(*this));
+      //two valueless variants are equal
+      return valueless_by_exception() ||
+        detail::dispatcher
+        <
+          bool,
+          sizeof...(Types),
+          detail::equal_caller
+        >::dispatch(index(), *this, rhs);
     }
 
-    size_t which() const {return m_which;}
+    constexpr size_t which() const {return index();}
 
-    size_t index() const { return m_which; }
+    constexpr size_t index() const { return base::index(); }
 
-    bool
+    constexpr bool
     valueless_by_exception() const
     {
-      return m_which == tuple_not_found;
+      return index() == tuple_not_found;
     }
 
     template <typename Internal, typename Visitor, typename... Args>
     decltype(auto)
     apply_visitor(Visitor&& visitor, Args&&... args)
     {
-      return do_visit<Types...>()(Internal(), m_which, &m_storage,
+      return this->template visit_storage<Internal>(
         std::forward<Visitor>(visitor), std::forward<Args>(args)...);
     }
 
@@ -1052,143 +2742,104 @@ namespace juice
     decltype(auto)
     apply_visitor(Visitor&& visitor, Args&&... args) const
     {
-      return do_visit<Types...>()(Internal(), m_which, &m_storage,
+      return this->template visit_storage<Internal>(
         std::forward<Visitor>(visitor), std::forward<Args>(args)...);
     }
 
+    //Swaps the bytes of the variants when they are trivially relocatable,
+    //the values when they hold the same alternative, and otherwise moves
+    //through a temporary.
     void
     swap(variant& rhs)
     {
-      if (m_which == rhs.index())
-      {
-        apply_visitor(detail::swapper(), *this, rhs);
-      }
-      else
-      {
-        swap(*this, rhs);
-      }
+      swap(rhs, std::integral_constant<bool,
+        is_trivially_relocatable<variant>::value>());
     }
 
     template <size_t I>
-    const typename std::tuple_element<I, variant<Types...>>::type&
+    constexpr const typename std::tuple_element<I, variant<Types...>>::type&
     //auto&
     get() const &
     {
-      if (index() != I)
+      if (JUICE_UNLIKELY(index() != I))
       {
-        throw bad_variant_access("Tuple does not contain requested item");
+        detail::bad_access<variant, I>();
       }
 
-      return reinterpret_cast<
-        const ref_type_t<
-          typename std::tuple_element<I, variant>::type
-        >&
-      >(
-        m_storage
-      );
+      return detail::union_access::get<I>(m_storage);
     }
 
     template <size_t I>
-    typename std::tuple_element<I, variant<Types...>>::type&
+    constexpr typename std::tuple_element<I, variant<Types...>>::type&
     //auto&
     get() &
     {
-      using E = typename std::tuple_element<I, variant>::type;
-      if (index() != I)
+      if (JUICE_UNLIKELY(index() != I))
       {
-        throw bad_variant_access("Tuple does not contain requested item");
+        detail::bad_access<variant, I>();
       }
 
-      return 
-        reinterpret_cast<
-          ref_type_t<E>&
-        >
-        (
-          m_storage
-        );
+      return detail::union_access::get<I>(m_storage);
     }
 
     template <size_t I>
-    typename std::tuple_element<I, variant>::type&&
+    constexpr typename std::tuple_element<I, variant>::type&&
     get() &&
     {
-      using E = typename std::tuple_element<I, variant>::type;
-      if (index() != I)
+      if (JUICE_UNLIKELY(index() != I))
       {
-        throw bad_variant_access("Tuple does not contain requested item");
+        detail::bad_access<variant, I>();
       }
 
-      return 
-        std::move(
-          reinterpret_cast<
-            ref_type_t<E>&
-          >
-          (
-            m_storage
-          )
-        );
-
+      return std::move(detail::union_access::get<I>(m_storage));
     }
 
     private:
 
-    typename 
-      std::aligned_storage<m_size, max<Alignof, Types...>::value>::type
-      m_storage;
-
-    size_t m_which;
-
     static std::function<void(void*)> m_handlers[1 + sizeof...(Types)];
 
-    void indicate_which(size_t which) {m_which = which;}
-
-    void* address() {return &m_storage;}
-    const void* address() const {return &m_storage;}
-
-    template <typename Visitor>
-    decltype(auto)
-    apply_visitor_internal(Visitor&& visitor)
-    {
-      return apply_visitor<MPL::true_, Visitor>(std::forward<Visitor>(visitor));
-    }
-
-    template <typename Visitor>
-    decltype(auto)
-    apply_visitor_internal(Visitor&& visitor) const
+    void
+    swap(variant& rhs, std::true_type) noexcept
     {
-      return apply_visitor<MPL::true_, Visitor>(std::forward<Visitor>(visitor));
+      alignas(variant) unsigned char tmp[sizeof(variant)];
+      std::memcpy(tmp, static_cast<void*>(this), sizeof(variant));
+      std::memcpy(static_cast<void*>(this), static_cast<void*>(&rhs),
+        sizeof(variant));
+      std::memcpy(static_cast<void*>(&rhs), tmp, sizeof(variant));
     }
 
     void
-    destroy()
+    swap(variant& rhs, std::false_type)
     {
-      //shortcut here to bypass calling the empty destroy function
-      if (index() != tuple_not_found)
+      if (index() != rhs.index())
       {
-        apply_visitor_internal(destroyer());
-        indicate_which(tuple_not_found);
+        variant tmp(std::move(rhs));
+        rhs = std::move(*this);
+        *this = std::move(tmp);
+      }
+      else if (!valueless_by_exception())
+      {
+        detail::dispatcher
+        <
+          void,
+          sizeof...(Types),
+          detail::swap_caller
+        >::dispatch(index(), m_storage, rhs.m_storage);
       }
     }
 
-    template <typename T, typename... Args>
-    constexpr
-    void
-    emplace_internal(Args&&... args)
-    {
-      new(&m_storage) T(std::forward<Args>(args)...);
-    }
+    friend struct detail::variant_access;
+    friend detail::variant_profiler<variant>;
 
-    template <typename T, typename U>
-    constexpr
-    void
-    construct(U&& t)
-    {
-      using R = typename std::conditional<std::is_reference<T>::value, 
-        ref<T>, T>::type;
-      new(&m_storage) R(std::forward<U>(t));
-    }
   };
 
+  template <typename... Types>
+  void
+  swap(variant<Types...>& a, variant<Types...>& b)
+  {
+    a.swap(b);
+  }
+
   template <typename... Types>
   using Variant = variant<Types...>;
 
@@ -1208,7 +2859,7 @@ namespace juice
     result_type
     operator()()
     {
-      throw bad_get();
+      detail::raise<bad_get>();
     }
 
     result_type
@@ -1238,117 +2889,336 @@ namespace juice
       (std::forward<Visitor>(visitor), std::forward<Args>(args)...);
   }
 
-//#if __cpp_generic_lambdas >= 201304 && __cpp_decltype_auto >= 201304
-  template <typename Visitor>
-  auto
-  apply_visitor(Visitor&& visitor)
+  namespace detail
   {
-    return [&visitor] (auto... values) -> auto
+    struct variant_access
     {
-      return apply_visitor(visitor, values...);
-    };
-  }
-//#endif
+      template <size_t I, typename... Types>
+      static constexpr
+      ref_type_t<std::tuple_element_t<I, variant<Types...>>>&
+      get(variant<Types...>& v)
+      {
+        return union_access::get<I>(v.m_storage);
+      }
 
-  template <typename Visitor, typename... Visited>
-  class MultiVisitor
-  {
-    public:
+      template <size_t I, typename... Types>
+      static constexpr
+      const ref_type_t<std::tuple_element_t<I, variant<Types...>>>&
+      get(const variant<Types...>& v)
+      {
+        return union_access::get<I>(v.m_storage);
+      }
 
-    constexpr
-    MultiVisitor(Visitor&& vis, Visited&&... vs)
-    : m_vis(std::forward<Visitor>(vis))
-    , m_vs(std::forward<Visited>(vs)...)
+      template <size_t I, typename... Types>
+      static constexpr
+      ref_type_t<std::tuple_element_t<I, variant<Types...>>>&&
+      get(variant<Types...>&& v)
+      {
+        return std::move(union_access::get<I>(v.m_storage));
+      }
+    };
+
+    struct equal_caller
     {
-    }
+      template <size_t I, typename Variant>
+      static constexpr bool
+      call(const Variant& v, const Variant& w)
+      {
+        return get_value(variant_access::get<I>(v), MPL::false_()) ==
+          get_value(variant_access::get<I>(w), MPL::false_());
+      }
+    };
 
-    template <typename First, int... I>
-    constexpr
-    auto
-    make_multi(Visitor&& v, std::integer_sequence<int, I...>, First&& f)
+    struct compare_caller
     {
-      return MultiVisitor<Visitor, Visited..., First>(
-        std::forward<Visitor>(v),
-        std::get<I>(m_vs)...,
-        std::forward<First>(f));
-    }
+      template <size_t I, typename Variant>
+      static constexpr int
+      call(const Variant& v, const Variant& w)
+      {
+        return compare_values(
+          get_value(variant_access::get<I>(v), MPL::false_()),
+          get_value(variant_access::get<I>(w), MPL::false_()));
+      }
 
-    decltype(auto)
-    operator()() const
+      template <typename T>
+      static constexpr int
+      compare_values(const T& a, const T& b)
+      {
+        return a < b ? -1 : (b < a ? 1 : 0);
+      }
+    };
+
+    //Visits several variants with a single dispatch. The indices of the
+    //variants are combined into one index, i0 * N1 * N2 + i1 * N2 + i2 for
+    //three variants, and each of the N0 * N1 * N2 combinations is a case of
+    //the dispatcher.
+    template <typename... Variants>
+    struct multi_index
     {
-      //this is an interesting case, if one of the values is empty,
-      //what can we return here? We should probably return the empty case
-      //of the base visitor
-      //although is it interesting for anyone that we allow arbitrary
-      //variants in the multi visit to be empty? If we do, then the number
-      //of functions needed to handle this grows quickly, a three visitor
-      //would require all possible binary and unary cases,
-      //although a variadic pack takes care of anything that you don't care
-      //about if you only want to cover a few cases.
-      return m_vis();
-    }
+      static constexpr size_t
+      size(size_t k)
+      {
+        constexpr size_t sizes[] =
+          {std::tuple_size<std::decay_t<Variants>>::value...};
+        return sizes[k];
+      }
 
-    template <typename First, typename... Values>
-    decltype(auto)
-    operator()(First&& f, Values&&... values)
+      //the product of the sizes of the variants after k
+      static constexpr size_t
+      stride(size_t k)
+      {
+        size_t s = 1;
+        for (size_t j = k + 1; j < sizeof...(Variants); ++j)
+        {
+          s *= size(j);
+        }
+        return s;
+      }
+
+      static constexpr size_t combinations = stride(0) * size(0);
+
+      //the index of variant k in combination I
+      static constexpr size_t
+      alternative(size_t I, size_t k)
+      {
+        return I / stride(k) % size(k);
+      }
+
+      static constexpr size_t
+      combine(const Variants&... vs)
+      {
+        size_t index = 0;
+        size_t k = 0;
+        using expand = int[];
+        (void)expand{0, (
+          assert(vs.index() < size(k++)),
+          index = index * std::tuple_size<std::decay_t<Variants>>::value +
+            vs.index(),
+        0)...};
+        (void)k;
+        return index;
+      }
+    };
+
+    //Variants are the variants as they were passed to visit, so that each is
+    //forwarded to the visitor as an lvalue or an rvalue
+    template <typename R, typename... Variants>
+    struct multi_caller
     {
-      return 
-        make_multi(std::forward<Visitor>(m_vis), 
-          std::make_integer_sequence<int, sizeof...(Visited)>(), 
-          std::forward<First>(f))
-        .visit(std::forward<Values>(values)...);
-    }
+      typedef multi_index<std::decay_t<Variants>...> index;
 
-    template <typename... Types, typename... Args>
-    decltype(auto)
-    visit(const variant<Types...>& var, Args&&... args)
+      template <size_t I, size_t... K, typename Visitor, typename... Args>
+      static constexpr decltype(auto)
+      invoke(std::index_sequence<K...>, Visitor&& visitor,
+        std::tuple<Variants&...>& variants, Args&&... args)
+      {
+        return std::forward<Visitor>(visitor)
+        (
+          get_value(
+            variant_access::get<index::alternative(I, K)>(
+              std::forward<Variants>(std::get<K>(variants))),
+            MPL::false_())...,
+          std::forward<Args>(args)...
+        );
+      }
+
+      template <size_t I, typename Visitor, typename... Args>
+      static constexpr decltype(auto)
+      invoke(Visitor&& visitor, std::tuple<Variants&...>& variants,
+        Args&&... args)
+      {
+        return invoke<I>(std::index_sequence_for<Variants...>(),
+          std::forward<Visitor>(visitor), variants,
+          std::forward<Args>(args)...);
+      }
+
+      template <size_t I, typename Visitor, typename Tuple, typename... Args>
+      static constexpr R
+      call(Visitor&& visitor, Tuple&& variants, Args&&... args)
+      {
+        return invoke<I>(std::forward<Visitor>(visitor), variants,
+          std::forward<Args>(args)...);
+      }
+    };
+
+    //the index of each of the Hot types in the only variant visited, Hot
+    //is empty when visiting several
+    template <typename Values, typename... Hot>
+    using hot_indices = std::index_sequence<
+      tuple_find<Hot, std::decay_t<std::tuple_element_t<0, Values>>>::value...
+    >;
+
+    template <typename R, size_t N, typename Caller, typename Seq>
+    struct hinted_dispatcher_for;
+
+    template <typename R, size_t N, typename Caller, size_t... Hot>
+    struct hinted_dispatcher_for<R, N, Caller, std::index_sequence<Hot...>>
     {
-      return var.template
-        apply_visitor<MPL::false_>(*this, std::forward<Args>(args)...);
-    }
+      typedef hinted_dispatcher<R, N, Caller, Hot...> type;
+    };
 
-    template <typename... Types, typename... Args>
-    decltype(auto)
-    visit(variant<Types...>& var, Args&&... args)
+    template <typename R, size_t N, typename Caller, typename Seq>
+    using hinted_dispatcher_t =
+      typename hinted_dispatcher_for<R, N, Caller, Seq>::type;
+
+    template <typename Visitor, typename Values, size_t... V, size_t... A,
+      typename... Hot>
+    constexpr decltype(auto)
+    multi_visit(likely<Hot...>, std::index_sequence<V...>,
+      std::index_sequence<A...>, Visitor&& visitor, Values values)
     {
-      return var.template
-        apply_visitor<MPL::false_>(*this, std::forward<Args>(args)...);
+      constexpr size_t K = sizeof...(V);
+
+      typedef multi_caller
+      <
+        void,
+        std::tuple_element_t<V, Values>...
+      > probe;
+
+      typedef typename multi_result
+      <
+        probe,
+        std::make_index_sequence<probe::index::combinations>,
+        Visitor,
+        std::tuple<
+          std::remove_reference_t<std::tuple_element_t<V, Values>>&...
+        >&,
+        std::tuple_element_t<K + A, Values>...
+      >::type result;
+
+      typedef multi_caller
+      <
+        result,
+        std::tuple_element_t<V, Values>...
+      > caller;
+
+      std::tuple<
+        std::remove_reference_t<std::tuple_element_t<V, Values>>&...
+      > variants(std::get<V>(values)...);
+
+#ifdef JUICE_VARIANT_PROFILE
+      profile::detail::count_visits(std::get<V>(values)...);
+#endif
+
+      static_assert(sizeof...(Hot) == 0 || K == 1,
+        "likely alternatives are only for visiting one variant");
+
+      return hinted_dispatcher_t
+      <
+        result,
+        caller::index::combinations,
+        caller,
+        hot_indices<Values, Hot...>
+      >::dispatch
+      (
+        caller::index::combine(std::get<V>(values)...),
+        std::forward<Visitor>(visitor),
+        variants,
+        std::forward<std::tuple_element_t<K + A, Values>>(
+          std::get<K + A>(values))...
+      );
     }
+  }
 
-    template <typename... Types, typename... Args>
-    decltype(auto)
-    visit(variant<Types...>&& var, Args&&... args)
+  //Visits the variants at the front of args with visitor. Any arguments
+  //after the variants are passed on to the visitor. There must be at least
+  //one variant, so that this doesn't compete with std::visit for a
+  //std::variant. A single variant is dispatched with its dispatch_hint.
+  template <typename Visitor, typename... Values,
+    typename = std::enable_if_t<
+      (detail::leading_variants<Values...>::value > 0)>>
+  constexpr decltype(auto)
+  visit(Visitor&& vis, Values&&... args)
+  {
+    constexpr size_t K = detail::leading_variants<Values...>::value;
+
+    typedef std::conditional_t
+    <
+      K == 1,
+      typename dispatch_hint<
+        std::decay_t<typename detail::pack_first<Values...>::type>
+      >::type,
+      likely<>
+    > hint;
+
+    return detail::multi_visit(hint(), std::make_index_sequence<K>(),
+      std::make_index_sequence<sizeof...(Values) - K>(),
+      std::forward<Visitor>(vis),
+      std::forward_as_tuple(std::forward<Values>(args)...));
+  }
+
+  //Visits v, checking for the Likely alternatives first and in order
+  //instead of those of its dispatch_hint. Any further arguments are passed
+  //on to the visitor.
+  template <typename... Likely, typename Visitor, typename Variant,
+    typename... Args>
+  constexpr decltype(auto)
+  visit_likely(Visitor&& vis, Variant&& v, Args&&... args)
+  {
+    static_assert(detail::is_variant<std::decay_t<Variant>>::value,
+      "visit_likely visits one variant");
+
+    return detail::multi_visit(likely<Likely...>(),
+      std::make_index_sequence<1>(),
+      std::make_index_sequence<sizeof...(Args)>(),
+      std::forward<Visitor>(vis),
+      std::forward_as_tuple(std::forward<Variant>(v),
+        std::forward<Args>(args)...));
+  }
+
+  //A visitation that is set up now and made later: calling it visits the
+  //variants passed to it, which are forwarded without being copied. When
+  //Visitor is an lvalue reference it refers to the visitor, which must
+  //outlive it, otherwise it owns a visitor that was moved into it. Either
+  //way it can be copied and assigned, so that it can be kept with other
+  //callbacks.
+  template <typename Visitor>
+  class delayed_visitor
+  {
+    typedef std::conditional_t
+    <
+      std::is_lvalue_reference<Visitor>::value,
+      std::reference_wrapper<std::remove_reference_t<Visitor>>,
+      Visitor
+    > stored_type;
+
+    public:
+    typedef std::remove_reference_t<Visitor> visitor_type;
+
+    explicit delayed_visitor(Visitor&& visitor)
+    : m_visitor(std::forward<Visitor>(visitor))
     {
-      return std::move(var).template
-        apply_visitor<MPL::false_>(*this, std::forward<Args>(args)...);
     }
 
-    template <int... I, typename... Args>
+    template <typename... Values>
     decltype(auto)
-    do_visit(std::integer_sequence<int, I...>, Visitor&& v, Args&&... args)
+    operator()(Values&&... values)
     {
-      return std::forward<Visitor>(v)
-        (std::get<I>(m_vs)..., std::forward<Args>(args)...);
+      return juice::visit(static_cast<visitor_type&>(m_visitor),
+        std::forward<Values>(values)...);
     }
 
-    template <typename... Args>
+    template <typename... Values>
     decltype(auto)
-    visit(Args&&... args)
+    operator()(Values&&... values) const
     {
-      return do_visit(std::make_integer_sequence<int, sizeof...(Visited)>(),
-        std::forward<Visitor>(m_vis), std::forward<Args>(args)...);
+      return juice::visit(static_cast<const visitor_type&>(m_visitor),
+        std::forward<Values>(values)...);
     }
 
     private:
-    Visitor&& m_vis;
-    std::tuple<Visited&...> m_vs;
+    stored_type m_visitor;
   };
 
-  template <typename Visitor, typename... Values>
-  decltype(auto)
-  visit(Visitor&& vis, Values&&... args)
+  //Delays a visitation with visitor, which is referred to when it is an
+  //lvalue and moved in when it is an rvalue, so for example
+  //apply_visitor(Printer()) can be stored and called after the Printer
+  //would have been destroyed.
+  template <typename Visitor>
+  delayed_visitor<Visitor>
+  apply_visitor(Visitor&& visitor)
   {
-    return MultiVisitor<Visitor>(std::forward<Visitor>(vis)).visit(args...);
+    return delayed_visitor<Visitor>(std::forward<Visitor>(visitor));
   }
 
   // == variant get ==
@@ -1357,7 +3227,7 @@ namespace juice
 
   template <size_t I, typename... Types>
   //typename std::tuple_element<I, variant<Types...>>::type&
-  auto&
+  constexpr auto&
   get(variant<Types...>& v)
   {
     return recursive_unwrap(v.template get<I>());
@@ -1365,21 +3235,21 @@ namespace juice
 
   template <size_t I, typename... Types>
   //typename std::tuple_element<I, variant<Types...>>::type&
-  auto&
+  constexpr auto&
   get(const variant<Types...>& v)
   {
     return recursive_unwrap(v.template get<I>());
   }
 
   template <size_t I, typename... Types>
-  auto&&
+  constexpr auto&&
   get(variant<Types...>&& v)
   {
     return recursive_unwrap(std::move(v).template get<I>());
   }
 
   template <size_t I, typename... Types>
-  std::add_pointer_t<
+  constexpr std::add_pointer_t<
     unwrapped_type_t<std::tuple_element_t<I, variant<Types...>>>
   >
   get_if(variant<Types...>* v)
@@ -1393,7 +3263,7 @@ namespace juice
   }
 
   template <size_t I, typename... Types>
-  const
+  constexpr const
   std::add_pointer_t<const
     unwrapped_type_t<std::tuple_element_t<I, variant<Types...>>>
   >
@@ -1410,7 +3280,7 @@ namespace juice
   // === then the type versions ===
 
   template <typename T, typename... Types>
-  std::add_pointer_t<T>
+  constexpr std::add_pointer_t<T>
   get_if(variant<Types...>* var)
   {
     //return visit(get_visitor<T>(), *var);
@@ -1418,15 +3288,61 @@ namespace juice
   }
 
   template <typename T, typename... Types>
-  const std::add_pointer_t<const T>
+  constexpr const std::add_pointer_t<const T>
   get_if(const variant<Types...>* var)
   {
     //return visit(get_visitor<const T>(), *var);
     return get_if<tuple_find<T, variant<Types...>>::value>(var);
   }
 
+  //Gets the I'th alternative, or the reason that v doesn't hold it, with
+  //one compare in the common case and without throwing.
+  template <size_t I, typename... Types>
+  constexpr access_result<
+    unwrapped_type_t<std::tuple_element_t<I, variant<Types...>>>
+  >
+  try_get(variant<Types...>& v)
+  {
+    if (JUICE_UNLIKELY(v.index() != I))
+    {
+      return v.valueless_by_exception() ? access_error::valueless :
+        access_error::wrong_alternative;
+    }
+
+    return recursive_unwrap(get<I>(v));
+  }
+
+  template <size_t I, typename... Types>
+  constexpr access_result<const
+    unwrapped_type_t<std::tuple_element_t<I, variant<Types...>>>
+  >
+  try_get(const variant<Types...>& v)
+  {
+    if (JUICE_UNLIKELY(v.index() != I))
+    {
+      return v.valueless_by_exception() ? access_error::valueless :
+        access_error::wrong_alternative;
+    }
+
+    return recursive_unwrap(get<I>(v));
+  }
+
   template <typename T, typename... Types>
-  T&
+  constexpr access_result<T>
+  try_get(variant<Types...>& v)
+  {
+    return try_get<tuple_find<T, variant<Types...>>::value>(v);
+  }
+
+  template <typename T, typename... Types>
+  constexpr access_result<const T>
+  try_get(const variant<Types...>& v)
+  {
+    return try_get<tuple_find<T, variant<Types...>>::value>(v);
+  }
+
+  template <typename T, typename... Types>
+  constexpr T&
   get (variant<Types...>& var)
   {
     //T* t = visit(get_visitor<T>(), var);
@@ -1437,7 +3353,7 @@ namespace juice
   }
 
   template <typename T, typename... Types>
-  const T&
+  constexpr const T&
   get (const variant<Types...>& var)
   {
     //const T* t = visit(get_visitor<const T>(), &var);
@@ -1448,7 +3364,7 @@ namespace juice
   }
 
   template <typename T, typename... Types>
-  T&&
+  constexpr T&&
   get(variant<Types...>&& v)
   {
     return get<tuple_find<T, variant<Types...>>::value>(std::move(v));
@@ -1479,14 +3395,14 @@ namespace juice
   };
 
   template <typename T, typename V>
-  bool
+  constexpr bool
   variant_is_type(const V& v)
   {
     return get_if<T>(&v) != nullptr;
   }
 
   template <typename T, typename... Types>
-  bool holds_alternative(const variant<Types...>& v)
+  constexpr bool holds_alternative(const variant<Types...>& v)
   {
     return variant_is_type<T>(v);
   }
@@ -1514,118 +3430,191 @@ namespace juice
   }
 
 
-  template <template <typename> class Compare>
-  struct RelationalVisitor
+  //Three way comparison of two variants, which is negative if v is less
+  //than w, zero if they are equivalent and positive if v is greater. The
+  //variants are ordered by index first, with a valueless variant before
+  //any other, and then by operator< on the alternative.
+  template <typename... Types>
+  constexpr int
+  compare(const variant<Types...>& v, const variant<Types...>& w)
   {
-    template <typename T, typename U>
-    bool
-    operator()(const T& t, const U& u) const
-    {
-      //this one should never be called
-      assert(false);
-    }
+    //the valueless index is tuple_not_found, which the + 1 makes 0
+    size_t i = v.index() + 1;
+    size_t j = w.index() + 1;
 
-    bool
-    operator()() const
+    if (i != j)
     {
-      //always false if one is empty
-      return false;
+      return i < j ? -1 : 1;
     }
 
-    template <typename T>
-    bool
-    operator()(const T& a, const T& b) const
-    {
-      return Compare<T>()(a, b);
-    }
-  };
+    return i == 0 ? 0 :
+      detail::dispatcher
+      <
+        int,
+        sizeof...(Types),
+        detail::compare_caller
+      >::dispatch(v.index(), v, w);
+  }
 
   template <template <typename> class Compare>
   struct variantCompare
   {
     template <typename... Types>
-    bool
+    constexpr bool
     operator()(const variant<Types...>& v, const variant<Types...>& w)
     {
-      if (Compare<int>()(v.which(), w.which()))
-      {
-        return true;
-      }
-      else if (v.which() == w.which())
-      {
-        return visit(RelationalVisitor<Compare>(), v, w);
-      }
-      else
-      {
-        return false;
-      }
+      return Compare<int>()(compare(v, w), 0);
     }
   };
 
   template <typename... Types>
-  bool
+  constexpr bool
+  operator!=(const variant<Types...>& v, const variant<Types...>& w)
+  {
+    return !(v == w);
+  }
+
+  template <typename... Types>
+  constexpr bool
   operator<(const variant<Types...>& v, const variant<Types...>& w)
   {
-    return variantCompare<std::less>()(v, w);
+    return compare(v, w) < 0;
   }
 
   template <typename... Types>
-  bool
+  constexpr bool
   operator>(const variant<Types...>& v, const variant<Types...>& w)
   {
-    return variantCompare<std::greater>()(v, w);
+    return compare(v, w) > 0;
   }
 
   template <typename... Types>
-  bool
+  constexpr bool
   operator<=(const variant<Types...>& v, const variant<Types...>& w)
   {
-    return !variantCompare<std::greater>()(w, v);
+    return compare(v, w) <= 0;
   }
 
   template <typename... Types>
-  bool
+  constexpr bool
   operator>=(const variant<Types...>& v, const variant<Types...>& w)
   {
-    return !variantCompare<std::less>()(v, w);
+    return compare(v, w) >= 0;
   }
-}
-
-namespace std {
-  using juice::visit;
-  using juice::get;
 
   namespace detail
   {
-    inline
+    //the 64 bit finaliser of MurmurHash3, every input bit affects every
+    //output bit
+    constexpr std::uint64_t
+    hash_mix(std::uint64_t h)
+    {
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return h;
+    }
+
+    //The hash of the value of the I'th alternative before it is mixed,
+    //which is the hash of the value and a constant for the alternative, so
+    //that equal values of different alternatives hash differently.
+    template <size_t I, typename T>
+    std::uint64_t
+    alternative_hash_seed(const T& t)
+    {
+      constexpr std::uint64_t salt = hash_mix(I + 1);
+      return static_cast<std::uint64_t>(std::hash<T>()(t)) ^ salt;
+    }
+
+    //the hash of a variant holding value as its I'th alternative
+    template <size_t I, typename T>
     size_t
-    hash_combine(size_t seed, size_t combine)
+    alternative_hash(const T& value)
     {
-      return seed ^ (combine + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+      return static_cast<size_t>(hash_mix(alternative_hash_seed<I>(value)));
     }
 
-    struct hash_visitor
+    struct hash_seed_caller
     {
-      template <typename T>
-      size_t
-      operator()(const T& t)
+      template <size_t I, typename Variant>
+      static std::uint64_t
+      call(const Variant& v)
       {
-        type_index ti(typeid(t));
-        size_t h = std::hash<type_index>()(ti);
-        h = hash_combine(h, std::hash<T>()(t));
-
-        return h;
+        return alternative_hash_seed<I>(
+          get_value(variant_access::get<I>(v), MPL::false_()));
       }
     };
+
+    template <typename... Types>
+    std::uint64_t
+    variant_hash_seed(const variant<Types...>& v)
+    {
+      if (v.valueless_by_exception())
+      {
+        //the seed of the valueless state, no alternative's salt is 0
+        return 0;
+      }
+
+      return dispatcher
+      <
+        std::uint64_t,
+        sizeof...(Types),
+        hash_seed_caller
+      >::dispatch(v.index(), v);
+    }
+
+    template <typename... Types>
+    size_t
+    hash_variant(const variant<Types...>& v)
+    {
+      return static_cast<size_t>(hash_mix(variant_hash_seed(v)));
+    }
+  }
+
+  //Writes std::hash of each variant in [first, last) to out. The hash of
+  //each value is found first, and then all of them are mixed in one loop
+  //that the compiler can vectorise.
+  template <typename... Types>
+  void
+  hash_batch(const variant<Types...>* first, const variant<Types...>* last,
+    size_t* out)
+  {
+    static_assert(sizeof(size_t) == sizeof(std::uint64_t),
+      "hash_batch keeps the 64 bit seeds in the output");
+
+    size_t n = last - first;
+    for (size_t i = 0; i != n; ++i)
+    {
+      out[i] = static_cast<size_t>(detail::variant_hash_seed(first[i]));
+    }
+
+    for (size_t i = 0; i != n; ++i)
+    {
+      out[i] = static_cast<size_t>(detail::hash_mix(out[i]));
+    }
   }
+}
+
+namespace std {
+  using juice::visit;
+  using juice::get;
+
+  //a variant can be constructed with any allocator, which is passed on to
+  //the alternatives that use it
+  template <typename... Types, typename Alloc>
+  struct uses_allocator<juice::variant<Types...>, Alloc> : public true_type
+  {
+  };
 
   template <typename... Types>
   struct hash<juice::variant<Types...>>
   {
     size_t
-    operator()(const juice::variant<Types...>& v)
+    operator()(const juice::variant<Types...>& v) const
     {
-      return visit(detail::hash_visitor(), v);
+      return juice::detail::hash_variant(v);
     }
   };
 
@@ -1633,7 +3622,7 @@ namespace std {
   struct hash<juice::monostate>
   {
     size_t
-    operator()(const juice::monostate&)
+    operator()(const juice::monostate&) const
     {
       return 47;
     }
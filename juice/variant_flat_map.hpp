@@ -0,0 +1,629 @@
+/* An open addressing hash map with variant keys.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// variant_flat_map<variant<Types...>, T> is a hash map from variants to T
+// that keeps its elements in one array, with linear probing and backward
+// shift deletion. Next to the array is a tag for each slot, which is 0 for
+// an empty slot, and otherwise the index of the key's alternative plus one
+// in the high byte and the top eight bits of the key's hash in the low
+// byte. A lookup hashes the key once for its alternative and compares the
+// keys of only those slots whose tag matches, which then hold the same
+// alternative, so neither the hash nor the comparison visits a variant.
+//
+// find and count also take a value of one of the alternatives, which is
+// looked up without building a variant from it.
+//
+// Inserting may move every element, which invalidates iterators and
+// references. Erasing moves elements within their probe sequence, so it
+// invalidates them too. Elements are moved as bytes when the key and the
+// mapped type are trivially relocatable.
+
+#ifndef JUICE_VARIANT_FLAT_MAP_HPP_INCLUDED
+#define JUICE_VARIANT_FLAT_MAP_HPP_INCLUDED
+
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include "variant.hpp"
+
+namespace juice
+{
+  template <typename Key, typename T>
+  class variant_flat_map;
+
+  namespace detail
+  {
+    //hashes the I'th alternative of a key and looks it up in a map
+    template <typename Probe>
+    struct flat_map_locator
+    {
+      template <size_t I, typename Map, typename Key>
+      static Probe
+      call(Map&& map, Key&& key)
+      {
+        const auto& value =
+          get_value(variant_access::get<I>(key), MPL::false_());
+        return map.template locate<I>(value, alternative_hash<I>(value));
+      }
+    };
+  }
+
+  template <typename T, typename... Types>
+  class variant_flat_map<variant<Types...>, T>
+  {
+    static_assert(sizeof...(Types) < 255,
+      "the alternative does not fit in the tag");
+
+    typedef std::uint16_t tag_type;
+
+    //where a key is, or the empty slot where it would go
+    struct probe
+    {
+      size_t position;
+      tag_type tag;
+      bool found;
+    };
+
+    template <typename>
+    friend struct detail::flat_map_locator;
+
+    public:
+    typedef variant<Types...> key_type;
+    typedef T mapped_type;
+    typedef std::pair<const key_type, T> value_type;
+    typedef size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <bool Const>
+    class basic_iterator
+    {
+      public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef variant_flat_map::value_type value_type;
+      typedef variant_flat_map::difference_type difference_type;
+      typedef std::conditional_t<Const, const value_type, value_type>&
+        reference;
+      typedef std::conditional_t<Const, const value_type, value_type>*
+        pointer;
+
+      typedef std::conditional_t<Const, const variant_flat_map,
+        variant_flat_map> container_type;
+
+      basic_iterator()
+      : m_map(nullptr), m_position(0)
+      {
+      }
+
+      basic_iterator(container_type* map, size_type position)
+      : m_map(map), m_position(position)
+      {
+      }
+
+      operator basic_iterator<true>() const
+      {
+        return basic_iterator<true>(m_map, m_position);
+      }
+
+      reference
+      operator*() const
+      {
+        return m_map->m_slots[m_position].value;
+      }
+
+      pointer
+      operator->() const
+      {
+        return &**this;
+      }
+
+      basic_iterator&
+      operator++()
+      {
+        m_position = m_map->next_occupied(m_position + 1);
+        return *this;
+      }
+
+      basic_iterator
+      operator++(int)
+      {
+        basic_iterator tmp(*this);
+        ++*this;
+        return tmp;
+      }
+
+      friend bool
+      operator==(const basic_iterator& a, const basic_iterator& b)
+      {
+        return a.m_position == b.m_position;
+      }
+
+      friend bool
+      operator!=(const basic_iterator& a, const basic_iterator& b)
+      {
+        return a.m_position != b.m_position;
+      }
+
+      private:
+      container_type* m_map;
+      size_type m_position;
+
+      friend class variant_flat_map;
+    };
+
+    typedef basic_iterator<false> iterator;
+    typedef basic_iterator<true> const_iterator;
+
+    variant_flat_map()
+    : m_capacity(0), m_size(0)
+    {
+    }
+
+    variant_flat_map(const variant_flat_map& rhs)
+    : variant_flat_map()
+    {
+      if (rhs.m_size != 0)
+      {
+        allocate(rhs.m_capacity);
+        for (size_type i = 0; i != m_capacity; ++i)
+        {
+          if (rhs.m_tags[i] != 0)
+          {
+            ::new (&m_slots[i].value) value_type(rhs.m_slots[i].value);
+            m_tags[i] = rhs.m_tags[i];
+            ++m_size;
+          }
+        }
+      }
+    }
+
+    variant_flat_map(variant_flat_map&& rhs) noexcept
+    : variant_flat_map()
+    {
+      swap(rhs);
+    }
+
+    ~variant_flat_map()
+    {
+      destroy_all();
+    }
+
+    variant_flat_map&
+    operator=(variant_flat_map rhs) noexcept
+    {
+      swap(rhs);
+      return *this;
+    }
+
+    void
+    swap(variant_flat_map& rhs) noexcept
+    {
+      using std::swap;
+      swap(m_slots, rhs.m_slots);
+      swap(m_tags, rhs.m_tags);
+      swap(m_capacity, rhs.m_capacity);
+      swap(m_size, rhs.m_size);
+    }
+
+    size_type
+    size() const
+    {
+      return m_size;
+    }
+
+    bool
+    empty() const
+    {
+      return m_size == 0;
+    }
+
+    size_type
+    bucket_count() const
+    {
+      return m_capacity;
+    }
+
+    iterator begin() { return iterator(this, next_occupied(0)); }
+    iterator end() { return iterator(this, m_capacity); }
+
+    const_iterator
+    begin() const
+    {
+      return const_iterator(this, next_occupied(0));
+    }
+
+    const_iterator end() const { return const_iterator(this, m_capacity); }
+
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    void
+    clear()
+    {
+      destroy_all();
+      m_size = 0;
+    }
+
+    //makes room for n elements without growing
+    void
+    reserve(size_type n)
+    {
+      if (n > max_load(m_capacity))
+      {
+        size_type capacity = m_capacity == 0 ? 16 : m_capacity;
+        while (n > max_load(capacity))
+        {
+          capacity *= 2;
+        }
+        rehash(capacity);
+      }
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool>
+    try_emplace(const key_type& key, Args&&... args)
+    {
+      return emplace_key(key, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool>
+    try_emplace(key_type&& key, Args&&... args)
+    {
+      return emplace_key(std::move(key), std::forward<Args>(args)...);
+    }
+
+    std::pair<iterator, bool>
+    insert(const value_type& value)
+    {
+      return emplace_key(value.first, value.second);
+    }
+
+    std::pair<iterator, bool>
+    insert(value_type&& value)
+    {
+      return emplace_key(value.first, std::move(value.second));
+    }
+
+    T&
+    operator[](const key_type& key)
+    {
+      return emplace_key(key).first->second;
+    }
+
+    T&
+    operator[](key_type&& key)
+    {
+      return emplace_key(std::move(key)).first->second;
+    }
+
+    //K is the key_type or one of its alternatives
+    template <typename K>
+    iterator
+    find(const K& key)
+    {
+      probe p = locate(key);
+      return p.found ? iterator(this, p.position) : end();
+    }
+
+    template <typename K>
+    const_iterator
+    find(const K& key) const
+    {
+      probe p = locate(key);
+      return p.found ? const_iterator(this, p.position) : end();
+    }
+
+    template <typename K>
+    size_type
+    count(const K& key) const
+    {
+      return locate(key).found ? 1 : 0;
+    }
+
+    template <typename K>
+    T&
+    at(const K& key)
+    {
+      auto it = find(key);
+      if (JUICE_UNLIKELY(it == end()))
+      {
+        detail::raise<std::out_of_range>("variant_flat_map::at");
+      }
+      return it->second;
+    }
+
+    template <typename K>
+    const T&
+    at(const K& key) const
+    {
+      auto it = find(key);
+      if (JUICE_UNLIKELY(it == end()))
+      {
+        detail::raise<std::out_of_range>("variant_flat_map::at");
+      }
+      return it->second;
+    }
+
+    void
+    erase(const_iterator it)
+    {
+      erase_at(it.m_position);
+    }
+
+    template <typename K>
+    size_type
+    erase(const K& key)
+    {
+      probe p = locate(key);
+      if (!p.found)
+      {
+        return 0;
+      }
+
+      erase_at(p.position);
+      return 1;
+    }
+
+    private:
+    union slot
+    {
+      slot() {}
+      ~slot() {}
+
+      value_type value;
+    };
+
+    std::unique_ptr<slot[]> m_slots;
+    std::unique_ptr<tag_type[]> m_tags;
+    size_type m_capacity;
+    size_type m_size;
+
+    //at most three quarters of the slots are used, so that probe sequences
+    //stay short
+    static size_type
+    max_load(size_type capacity)
+    {
+      return capacity - capacity / 4;
+    }
+
+    static tag_type
+    make_tag(size_t which, size_t hash)
+    {
+      return static_cast<tag_type>(((which + 1) << 8) |
+        (hash >> (std::numeric_limits<size_t>::digits - 8)));
+    }
+
+    size_type
+    home(size_t hash) const
+    {
+      return hash & (m_capacity - 1);
+    }
+
+    size_type
+    next_occupied(size_type position) const
+    {
+      while (position != m_capacity && m_tags[position] == 0)
+      {
+        ++position;
+      }
+      return position;
+    }
+
+    //the probe of a key holding value as its I'th alternative
+    template <size_t I, typename U>
+    probe
+    locate(const U& value, size_t hash) const
+    {
+      const tag_type tag = make_tag(I, hash);
+      const size_type mask = m_capacity - 1;
+
+      for (size_type position = home(hash); ;
+        position = (position + 1) & mask)
+      {
+        if (m_tags[position] == 0)
+        {
+          return probe{position, tag, false};
+        }
+
+        if (m_tags[position] == tag &&
+          detail::get_value(detail::variant_access::get<I>(
+            m_slots[position].value.first), MPL::false_()) == value)
+        {
+          return probe{position, tag, true};
+        }
+      }
+    }
+
+    probe
+    locate(const key_type& key) const
+    {
+      assert(!key.valueless_by_exception());
+
+      if (m_capacity == 0)
+      {
+        return probe{0, 0, false};
+      }
+
+      return detail::dispatcher
+      <
+        probe,
+        sizeof...(Types),
+        detail::flat_map_locator<probe>
+      >::dispatch(key.index(), *this, key);
+    }
+
+    template <typename U>
+    probe
+    locate(const U& value) const
+    {
+      constexpr size_t I = tuple_find<U, key_type>::value;
+      static_assert(I != tuple_not_found,
+        "the key is not an alternative of the key_type");
+
+      if (m_capacity == 0)
+      {
+        return probe{0, 0, false};
+      }
+
+      return locate<I>(value, detail::alternative_hash<I>(value));
+    }
+
+    //finding the key doesn't grow the map, so that it keeps the iterators
+    //and references of a lookup that only hits
+    template <typename K, typename... Args>
+    std::pair<iterator, bool>
+    emplace_key(K&& key, Args&&... args)
+    {
+      probe p = locate(static_cast<const key_type&>(key));
+      if (p.found)
+      {
+        return std::make_pair(iterator(this, p.position), false);
+      }
+
+      if (m_size + 1 > max_load(m_capacity))
+      {
+        reserve(m_size + 1);
+        p = locate(static_cast<const key_type&>(key));
+      }
+
+      ::new (&m_slots[p.position].value) value_type(
+        std::piecewise_construct,
+        std::forward_as_tuple(std::forward<K>(key)),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+      m_tags[p.position] = p.tag;
+      ++m_size;
+
+      return std::make_pair(iterator(this, p.position), true);
+    }
+
+    void
+    allocate(size_type capacity)
+    {
+      assert((capacity & (capacity - 1)) == 0);
+
+      m_slots.reset(new slot[capacity]);
+      m_tags.reset(new tag_type[capacity]());
+      m_capacity = capacity;
+    }
+
+    void
+    rehash(size_type capacity)
+    {
+      variant_flat_map grown;
+      grown.allocate(capacity);
+
+      const size_type mask = capacity - 1;
+      for (size_type i = 0; i != m_capacity; ++i)
+      {
+        if (m_tags[i] != 0)
+        {
+          value_type& value = m_slots[i].value;
+          size_type position = grown.home(detail::hash_variant(value.first));
+          while (grown.m_tags[position] != 0)
+          {
+            position = (position + 1) & mask;
+          }
+
+          if (is_trivially_relocatable<value_type>::value)
+          {
+            relocate(&value, &value + 1, &grown.m_slots[position].value);
+            grown.m_tags[position] = m_tags[i];
+            m_tags[i] = 0;
+          }
+          else
+          {
+            ::new (&grown.m_slots[position].value) value_type(
+              std::move_if_noexcept(value));
+            grown.m_tags[position] = m_tags[i];
+          }
+          ++grown.m_size;
+        }
+      }
+
+      swap(grown);
+    }
+
+    //Empties a slot, and then moves back each element after it in the
+    //cluster that would still be found from its home slot, so that no
+    //probe sequence has a hole in it.
+    void
+    erase_at(size_type hole)
+    {
+      const size_type mask = m_capacity - 1;
+
+      m_slots[hole].value.~value_type();
+      m_tags[hole] = 0;
+      --m_size;
+
+      for (size_type next = (hole + 1) & mask; m_tags[next] != 0;
+        next = (next + 1) & mask)
+      {
+        value_type& value = m_slots[next].value;
+        size_type from = home(detail::hash_variant(value.first));
+
+        if (((next - from) & mask) >= ((next - hole) & mask))
+        {
+          relocate(&value, &value + 1, &m_slots[hole].value);
+          m_tags[hole] = m_tags[next];
+          m_tags[next] = 0;
+          hole = next;
+        }
+      }
+    }
+
+    void
+    destroy_all()
+    {
+      for (size_type i = 0; i != m_capacity; ++i)
+      {
+        if (m_tags[i] != 0)
+        {
+          m_slots[i].value.~value_type();
+          m_tags[i] = 0;
+        }
+      }
+    }
+  };
+
+  template <typename Key, typename T>
+  void
+  swap(variant_flat_map<Key, T>& a, variant_flat_map<Key, T>& b) noexcept
+  {
+    a.swap(b);
+  }
+}
+
+#endif
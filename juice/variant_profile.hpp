@@ -0,0 +1,463 @@
+/* Counters of what happens to each alternative of variants.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// When JUICE_VARIANT_PROFILE is defined before variant.hpp is included,
+// every variant counts, for each of its alternatives, how many times it is
+// constructed with it, assigned to hold it, visited holding it, and how many
+// times get of it throws bad_variant_access. Without the macro none of this
+// is compiled into variant.
+//
+// The counters are kept per thread, without locking, and are merged when
+// profile::snapshot or profile::report is called, or when a thread exits.
+// A report is written to std::cerr at exit unless
+// profile::report_at_exit(false) is called. profile::write_hints turns the
+// visit counts into dispatch_hint specialisations, so that visit checks for
+// the alternatives seen most often first.
+//
+// Counting makes the special members of variant non-trivial, and variant
+// can't be used in constant expressions while profiling.
+
+#ifndef JUICE_VARIANT_PROFILE_HPP_INCLUDED
+#define JUICE_VARIANT_PROFILE_HPP_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace juice
+{
+  template <typename... Types>
+  class variant;
+
+  namespace profile
+  {
+    enum event
+    {
+      construction,
+      assignment,
+      visit,
+      bad_access
+    };
+
+    constexpr size_t events = 4;
+
+    //the counts of one alternative of one variant type
+    struct entry
+    {
+      std::string variant;
+      std::string alternative;
+      size_t index;
+      std::uint64_t counts[events];
+    };
+
+    namespace detail
+    {
+      //the name of T as the compiler spells it
+      template <typename T>
+      std::string
+      type_name()
+      {
+#if defined(__GNUC__)
+        std::string name = __PRETTY_FUNCTION__;
+        size_t first = name.find("T = ");
+        if (first == std::string::npos)
+        {
+          return name;
+        }
+        first += 4;
+        size_t last = name.find(';', first);
+        if (last == std::string::npos)
+        {
+          last = name.rfind(']');
+        }
+        return name.substr(first, last - first);
+#else
+        return "unknown";
+#endif
+      }
+
+      struct descriptor
+      {
+        std::string name;
+        std::vector<std::string> alternatives;
+      };
+
+      //never destroyed, so that it outlives the report at exit
+      template <typename... Types>
+      const descriptor&
+      describe(const variant<Types...>*)
+      {
+        static const descriptor* d = new descriptor{
+          type_name<variant<Types...>>(),
+          {type_name<Types>()...}
+        };
+        return *d;
+      }
+
+      class block;
+
+      class registry
+      {
+        public:
+        static registry&
+        instance()
+        {
+          static registry r;
+          return r;
+        }
+
+        ~registry()
+        {
+          if (m_report_at_exit)
+          {
+            report(std::cerr);
+          }
+        }
+
+        void
+        add(block* b)
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          m_live.push_back(b);
+        }
+
+        inline void retire(block* b);
+
+        inline std::vector<entry> snapshot();
+
+        void
+        report(std::ostream& out)
+        {
+          std::vector<entry> entries = snapshot();
+
+          out << "juice::variant profile\n";
+          const std::string* current = nullptr;
+          for (const entry& e : entries)
+          {
+            if (current == nullptr || *current != e.variant)
+            {
+              current = &e.variant;
+              out << e.variant << "\n"
+                << std::setw(6) << "index" << "  "
+                << std::left << std::setw(30) << "alternative" << " "
+                << std::right
+                << std::setw(14) << "constructions"
+                << std::setw(14) << "assignments"
+                << std::setw(14) << "visits"
+                << std::setw(14) << "bad_access" << "\n";
+            }
+
+            out << std::setw(6) << e.index << "  "
+              << std::left << std::setw(30) << e.alternative << " "
+              << std::right;
+            for (size_t i = 0; i != events; ++i)
+            {
+              out << std::setw(14) << e.counts[i];
+            }
+            out << "\n";
+          }
+          out.flush();
+        }
+
+        void
+        report_at_exit(bool on)
+        {
+          m_report_at_exit = on;
+        }
+
+        private:
+        registry() = default;
+
+        std::mutex m_mutex;
+        std::vector<block*> m_live;
+        std::map<const descriptor*, std::vector<std::uint64_t>> m_retired;
+        bool m_report_at_exit = true;
+      };
+
+      //The counters of one variant type in one thread. Only that thread
+      //writes them, so they are atomic just so that a snapshot can read
+      //them.
+      class block
+      {
+        public:
+        explicit block(const descriptor& d)
+        : m_type(&d)
+        , m_size(d.alternatives.size() * events)
+        , m_counts(new std::atomic<std::uint64_t>[m_size])
+        {
+          for (size_t i = 0; i != m_size; ++i)
+          {
+            m_counts[i].store(0, std::memory_order_relaxed);
+          }
+          registry::instance().add(this);
+        }
+
+        ~block()
+        {
+          registry::instance().retire(this);
+        }
+
+        block(const block&) = delete;
+        block& operator=(const block&) = delete;
+
+        void
+        add(size_t which, event e)
+        {
+          if (which < m_type->alternatives.size())
+          {
+            std::atomic<std::uint64_t>& c = m_counts[which * events + e];
+            c.store(c.load(std::memory_order_relaxed) + 1,
+              std::memory_order_relaxed);
+          }
+        }
+
+        const descriptor*
+        type() const
+        {
+          return m_type;
+        }
+
+        //adds the counts to totals, which has a count for each event of
+        //each alternative
+        void
+        merge(std::vector<std::uint64_t>& totals) const
+        {
+          totals.resize(m_size);
+          for (size_t i = 0; i != m_size; ++i)
+          {
+            totals[i] += m_counts[i].load(std::memory_order_relaxed);
+          }
+        }
+
+        private:
+        const descriptor* m_type;
+        size_t m_size;
+        std::unique_ptr<std::atomic<std::uint64_t>[]> m_counts;
+      };
+
+      void
+      registry::retire(block* b)
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        b->merge(m_retired[b->type()]);
+        m_live.erase(std::find(m_live.begin(), m_live.end(), b));
+      }
+
+      std::vector<entry>
+      registry::snapshot()
+      {
+        std::map<const descriptor*, std::vector<std::uint64_t>> totals;
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          totals = m_retired;
+          for (const block* b : m_live)
+          {
+            b->merge(totals[b->type()]);
+          }
+        }
+
+        std::vector<entry> entries;
+        for (const auto& t : totals)
+        {
+          const descriptor& d = *t.first;
+          for (size_t i = 0; i != d.alternatives.size(); ++i)
+          {
+            entry e{d.name, d.alternatives[i], i, {}};
+            std::copy(t.second.begin() + i * events,
+              t.second.begin() + (i + 1) * events, e.counts);
+            entries.push_back(e);
+          }
+        }
+
+        std::sort(entries.begin(), entries.end(),
+          [] (const entry& a, const entry& b) {
+            return a.variant < b.variant ||
+              (a.variant == b.variant && a.index < b.index);
+          });
+
+        return entries;
+      }
+
+      template <typename Variant>
+      void
+      count(event e, size_t which)
+      {
+        static thread_local block b(
+          describe(static_cast<const Variant*>(nullptr)));
+        b.add(which, e);
+      }
+
+      template <typename... Variants>
+      void
+      count_visits(const Variants&... vs)
+      {
+        using expand = int[];
+        (void)expand{0, (count<Variants>(visit, vs.index()), 0)...};
+      }
+
+      //A base of variant that counts its constructions and assignments
+      //once the alternative is in place. Variant must befriend it.
+      template <typename Variant>
+      class counter
+      {
+        public:
+        counter() noexcept
+        {
+          count_this(construction);
+        }
+
+        counter(const counter&) noexcept
+        {
+          count_this(construction);
+        }
+
+        counter(counter&&) noexcept
+        {
+          count_this(construction);
+        }
+
+        counter&
+        operator=(const counter&) noexcept
+        {
+          count_this(assignment);
+          return *this;
+        }
+
+        counter&
+        operator=(counter&&) noexcept
+        {
+          count_this(assignment);
+          return *this;
+        }
+
+        private:
+        void
+        count_this(event e) const noexcept
+        {
+          count<Variant>(e, static_cast<const Variant&>(*this).index());
+        }
+      };
+    }
+
+    //the counts so far of every alternative of every variant type that
+    //has been used, merged across threads
+    inline std::vector<entry>
+    snapshot()
+    {
+      return detail::registry::instance().snapshot();
+    }
+
+    inline void
+    report(std::ostream& out = std::cerr)
+    {
+      detail::registry::instance().report(out);
+    }
+
+    inline void
+    report_at_exit(bool on)
+    {
+      detail::registry::instance().report_at_exit(on);
+    }
+
+    //Writes a header that specialises dispatch_hint for each variant type
+    //that has been visited, so that a later build can visit the alternatives
+    //seen most often first. An alternative is listed when it has at least
+    //share of the visits of its variant, most visited first and no more than
+    //limit of them. The names are as the compiler spells them, so the header
+    //needs the types in scope and may need editing for types it can't name.
+    inline void
+    write_hints(std::ostream& out, double share = 0.125, size_t limit = 3)
+    {
+      std::vector<entry> entries = snapshot();
+
+      out << "// dispatch hints written by juice::profile::write_hints\n"
+        << "#include <juice/variant.hpp>\n\n"
+        << "namespace juice\n{\n";
+
+      auto first = entries.begin();
+      while (first != entries.end())
+      {
+        auto last = std::find_if(first, entries.end(),
+          [&] (const entry& e) { return e.variant != first->variant; });
+
+        std::uint64_t total = 0;
+        std::vector<const entry*> hot;
+        for (auto i = first; i != last; ++i)
+        {
+          total += i->counts[visit];
+          hot.push_back(&*i);
+        }
+
+        std::stable_sort(hot.begin(), hot.end(),
+          [] (const entry* a, const entry* b) {
+            return a->counts[visit] > b->counts[visit];
+          });
+
+        auto cold = std::find_if(hot.begin(), hot.end(),
+          [&] (const entry* e) {
+            return e->counts[visit] == 0 || e->counts[visit] < share * total;
+          });
+        hot.erase(cold, hot.end());
+        if (hot.size() > limit)
+        {
+          hot.resize(limit);
+        }
+
+        if (!hot.empty())
+        {
+          out << "  template <>\n"
+            << "  struct dispatch_hint<" << first->variant << ">\n"
+            << "  {\n"
+            << "    typedef likely<";
+          for (size_t i = 0; i != hot.size(); ++i)
+          {
+            out << (i == 0 ? "" : ", ") << hot[i]->alternative;
+          }
+          out << "> type;\n"
+            << "  };\n\n";
+        }
+
+        first = last;
+      }
+
+      out << "}\n";
+      out.flush();
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,624 @@
+/* A vector of variants that stores each alternative in its own array.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// variant_vector<Types...> is a sequence of variant<Types...> that keeps
+// the values of each alternative in a vector of their own. An element is a
+// tag, which is the index of its alternative, and the offset of its value
+// in the vector of that alternative. So an element costs the size of its
+// own value and five bytes, instead of the size of the largest alternative
+// and the index, and the values of one alternative can be scanned as an
+// array with alternatives<T>().
+//
+// Elements are accessed through proxy references. An element can't change
+// to another alternative, but its value can be modified through get.
+
+#ifndef JUICE_VARIANT_VECTOR_HPP_INCLUDED
+#define JUICE_VARIANT_VECTOR_HPP_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "variant.hpp"
+
+namespace juice
+{
+  namespace detail
+  {
+    //std::vector<bool> can't refer to its elements, so a bool alternative is
+    //kept in a vector of these instead
+    struct vector_bool
+    {
+      vector_bool(bool b = false)
+      : value(b)
+      {
+      }
+
+      operator bool() const
+      {
+        return value;
+      }
+
+      bool value;
+    };
+
+    //the type that the values of an alternative are kept as
+    template <typename T>
+    struct vector_value
+    {
+      typedef T type;
+    };
+
+    template <>
+    struct vector_value<bool>
+    {
+      typedef vector_bool type;
+    };
+
+    template <typename T>
+    using vector_value_t = typename vector_value<T>::type;
+
+    inline bool&
+    get_value(vector_bool& b, const MPL::false_&)
+    {
+      return b.value;
+    }
+
+    inline const bool&
+    get_value(const vector_bool& b, const MPL::false_&)
+    {
+      return b.value;
+    }
+
+    //calls the visitor with the value at offset in the I'th vector
+    template <typename R>
+    struct vector_caller
+    {
+      template <size_t I, typename Values, typename Offset,
+        typename Visitor>
+      static decltype(auto)
+      invoke(Values&& values, Offset&& offset, Visitor&& visitor)
+      {
+        return visitor(get_value(std::get<I>(values)[offset],
+          MPL::false_()));
+      }
+
+      template <size_t I, typename Values, typename Offset,
+        typename Visitor>
+      static R
+      call(Values&& values, Offset&& offset, Visitor&& visitor)
+      {
+        return invoke<I>(values, offset, visitor);
+      }
+    };
+
+    //copies the value at offset in the I'th vector into a variant
+    template <typename Variant>
+    struct vector_extractor
+    {
+      template <size_t I, typename Values, typename Offset>
+      static Variant
+      call(Values&& values, Offset&& offset)
+      {
+        return Variant(emplaced_index_t<I>(), std::get<I>(values)[offset]);
+      }
+    };
+
+    //appends the I'th alternative of a variant to a variant_vector
+    struct vector_appender
+    {
+      template <size_t I, typename Vector, typename Variant>
+      static void
+      call(Vector&& vector, Variant&& v)
+      {
+        vector.template emplace_back<I>(
+          std::forward<Variant>(v).template get<I>());
+      }
+    };
+
+    struct vector_popper
+    {
+      template <size_t I, typename Values>
+      static void
+      call(Values&& values)
+      {
+        std::get<I>(values).pop_back();
+      }
+    };
+  }
+
+  template <typename... Types>
+  class variant_vector
+  {
+    static_assert(conjunction<!std::is_reference<Types>::value...>::value,
+      "variant_vector can't hold references");
+
+    typedef std::tuple<std::vector<detail::vector_value_t<Types>>...>
+      values_type;
+    typedef detail::variant_index_t<sizeof...(Types)> tag_type;
+
+    public:
+    typedef variant<Types...> value_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    //A proxy for an element. It behaves like a variant that can't be
+    //assigned a different alternative.
+    template <bool Const>
+    class basic_reference
+    {
+      public:
+      typedef std::conditional_t<Const, const variant_vector, variant_vector>
+        container_type;
+
+      basic_reference(container_type* container, size_type position)
+      : m_container(container), m_position(position)
+      {
+      }
+
+      operator basic_reference<true>() const
+      {
+        return basic_reference<true>(m_container, m_position);
+      }
+
+      //a copy of the element as a variant
+      value_type
+      value() const
+      {
+        return detail::dispatcher
+        <
+          value_type,
+          sizeof...(Types),
+          detail::vector_extractor<value_type>
+        >::dispatch(index(), m_container->m_values, offset());
+      }
+
+      size_t
+      index() const
+      {
+        return m_container->m_tags[m_position];
+      }
+
+      template <size_t I>
+      auto&
+      get() const
+      {
+        if (JUICE_UNLIKELY(index() != I))
+        {
+          detail::bad_access<value_type, I>();
+        }
+
+        return detail::get_value(
+          std::get<I>(m_container->m_values)[offset()], MPL::false_());
+      }
+
+      template <typename T>
+      auto&
+      get() const
+      {
+        return get<tuple_find<T, value_type>::value>();
+      }
+
+      template <typename T>
+      bool
+      holds_alternative() const
+      {
+        return index() == tuple_find<T, value_type>::value;
+      }
+
+      template <typename Visitor>
+      decltype(auto)
+      visit(Visitor&& visitor) const
+      {
+        return m_container->visit_element(m_position, visitor);
+      }
+
+      private:
+      container_type* m_container;
+      size_type m_position;
+
+      size_type
+      offset() const
+      {
+        return m_container->m_offsets[m_position];
+      }
+    };
+
+    typedef basic_reference<false> reference;
+    typedef basic_reference<true> const_reference;
+
+    //A random access iterator over the elements. Since it dereferences to
+    //a proxy, it is only an input iterator to the standard library.
+    template <bool Const>
+    class basic_iterator
+    {
+      public:
+      typedef std::random_access_iterator_tag iterator_category;
+      typedef variant_vector::value_type value_type;
+      typedef variant_vector::difference_type difference_type;
+      typedef basic_reference<Const> reference;
+      typedef void pointer;
+
+      typedef typename reference::container_type container_type;
+
+      basic_iterator()
+      : m_container(nullptr), m_position(0)
+      {
+      }
+
+      basic_iterator(container_type* container, size_type position)
+      : m_container(container), m_position(position)
+      {
+      }
+
+      operator basic_iterator<true>() const
+      {
+        return basic_iterator<true>(m_container, m_position);
+      }
+
+      reference
+      operator*() const
+      {
+        return reference(m_container, m_position);
+      }
+
+      reference
+      operator[](difference_type n) const
+      {
+        return reference(m_container, m_position + n);
+      }
+
+      basic_iterator&
+      operator++()
+      {
+        ++m_position;
+        return *this;
+      }
+
+      basic_iterator
+      operator++(int)
+      {
+        basic_iterator tmp(*this);
+        ++m_position;
+        return tmp;
+      }
+
+      basic_iterator&
+      operator--()
+      {
+        --m_position;
+        return *this;
+      }
+
+      basic_iterator
+      operator--(int)
+      {
+        basic_iterator tmp(*this);
+        --m_position;
+        return tmp;
+      }
+
+      basic_iterator&
+      operator+=(difference_type n)
+      {
+        m_position += n;
+        return *this;
+      }
+
+      basic_iterator&
+      operator-=(difference_type n)
+      {
+        m_position -= n;
+        return *this;
+      }
+
+      friend basic_iterator
+      operator+(basic_iterator it, difference_type n)
+      {
+        return it += n;
+      }
+
+      friend basic_iterator
+      operator+(difference_type n, basic_iterator it)
+      {
+        return it += n;
+      }
+
+      friend basic_iterator
+      operator-(basic_iterator it, difference_type n)
+      {
+        return it -= n;
+      }
+
+      friend difference_type
+      operator-(const basic_iterator& a, const basic_iterator& b)
+      {
+        return static_cast<difference_type>(a.m_position) -
+          static_cast<difference_type>(b.m_position);
+      }
+
+      friend bool
+      operator==(const basic_iterator& a, const basic_iterator& b)
+      {
+        return a.m_position == b.m_position;
+      }
+
+      friend bool
+      operator!=(const basic_iterator& a, const basic_iterator& b)
+      {
+        return a.m_position != b.m_position;
+      }
+
+      friend bool
+      operator<(const basic_iterator& a, const basic_iterator& b)
+      {
+        return a.m_position < b.m_position;
+      }
+
+      friend bool
+      operator>(const basic_iterator& a, const basic_iterator& b)
+      {
+        return b < a;
+      }
+
+      friend bool
+      operator<=(const basic_iterator& a, const basic_iterator& b)
+      {
+        return !(b < a);
+      }
+
+      friend bool
+      operator>=(const basic_iterator& a, const basic_iterator& b)
+      {
+        return !(a < b);
+      }
+
+      private:
+      container_type* m_container;
+      size_type m_position;
+    };
+
+    typedef basic_iterator<false> iterator;
+    typedef basic_iterator<true> const_iterator;
+
+    size_type
+    size() const
+    {
+      return m_tags.size();
+    }
+
+    bool
+    empty() const
+    {
+      return m_tags.empty();
+    }
+
+    //reserves the tags and offsets, the vector of each alternative grows
+    //separately
+    void
+    reserve(size_type n)
+    {
+      m_tags.reserve(n);
+      m_offsets.reserve(n);
+    }
+
+    void
+    clear()
+    {
+      m_tags.clear();
+      m_offsets.clear();
+      clear_values(std::index_sequence_for<Types...>());
+    }
+
+    reference
+    operator[](size_type i)
+    {
+      assert(i < size());
+      return reference(this, i);
+    }
+
+    const_reference
+    operator[](size_type i) const
+    {
+      assert(i < size());
+      return const_reference(this, i);
+    }
+
+    reference front() { return (*this)[0]; }
+    const_reference front() const { return (*this)[0]; }
+
+    reference back() { return (*this)[size() - 1]; }
+    const_reference back() const { return (*this)[size() - 1]; }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size()); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    void
+    push_back(const value_type& v)
+    {
+      assert(!v.valueless_by_exception());
+      detail::dispatcher
+      <
+        void,
+        sizeof...(Types),
+        detail::vector_appender
+      >::dispatch(v.index(), *this, v);
+    }
+
+    void
+    push_back(value_type&& v)
+    {
+      assert(!v.valueless_by_exception());
+      detail::dispatcher
+      <
+        void,
+        sizeof...(Types),
+        detail::vector_appender
+      >::dispatch(v.index(), *this, std::move(v));
+    }
+
+    template <typename T, typename... Args>
+    reference
+    emplace_back(Args&&... args)
+    {
+      return emplace_back<tuple_find<T, value_type>::value>(
+        std::forward<Args>(args)...);
+    }
+
+    template <size_t I, typename... Args>
+    reference
+    emplace_back(Args&&... args)
+    {
+      auto& values = std::get<I>(m_values);
+
+      //the offsets of the values are 32 bits
+      if (JUICE_UNLIKELY(values.size() >=
+            std::numeric_limits<std::uint32_t>::max()))
+      {
+        detail::raise<std::length_error>(
+          "variant_vector has too many values of an alternative");
+      }
+
+      values.emplace_back(std::forward<Args>(args)...);
+      JUICE_TRY
+      {
+        m_offsets.push_back(static_cast<std::uint32_t>(values.size() - 1));
+        JUICE_TRY
+        {
+          m_tags.push_back(static_cast<tag_type>(I));
+        }
+        JUICE_CATCH_ALL
+        {
+          m_offsets.pop_back();
+          JUICE_RETHROW;
+        }
+      }
+      JUICE_CATCH_ALL
+      {
+        values.pop_back();
+        JUICE_RETHROW;
+      }
+
+      return back();
+    }
+
+    //the last element is also the last value of its alternative
+    void
+    pop_back()
+    {
+      assert(!empty());
+      detail::dispatcher
+      <
+        void,
+        sizeof...(Types),
+        detail::vector_popper
+      >::dispatch(m_tags.back(), m_values);
+      m_tags.pop_back();
+      m_offsets.pop_back();
+    }
+
+    //the values of the I'th alternative in the order they were added, where
+    //a bool is a detail::vector_bool that converts to it
+    template <size_t I>
+    const std::tuple_element_t<I, values_type>&
+    alternatives() const
+    {
+      return std::get<I>(m_values);
+    }
+
+    template <typename T>
+    const std::vector<detail::vector_value_t<T>>&
+    alternatives() const
+    {
+      return alternatives<tuple_find<T, value_type>::value>();
+    }
+
+    private:
+    values_type m_values;
+    std::vector<tag_type> m_tags;
+    std::vector<std::uint32_t> m_offsets;
+
+    template <size_t... I>
+    void
+    clear_values(std::index_sequence<I...>)
+    {
+      using expand = int[];
+      (void)expand{0, (std::get<I>(m_values).clear(), 0)...};
+    }
+
+    template <typename Visitor>
+    decltype(auto)
+    visit_element(size_type i, Visitor& visitor)
+    {
+      return visit_values(m_values, m_tags[i], m_offsets[i], visitor);
+    }
+
+    template <typename Visitor>
+    decltype(auto)
+    visit_element(size_type i, Visitor& visitor) const
+    {
+      return visit_values(m_values, m_tags[i], m_offsets[i], visitor);
+    }
+
+    template <typename Values, typename Visitor>
+    static decltype(auto)
+    visit_values(Values& values, size_t which, std::uint32_t offset,
+      Visitor& visitor)
+    {
+      typedef typename detail::multi_result
+      <
+        detail::vector_caller<void>,
+        std::index_sequence_for<Types...>,
+        Values&,
+        std::uint32_t&,
+        Visitor&
+      >::type result;
+
+      return detail::dispatcher
+      <
+        result,
+        sizeof...(Types),
+        detail::vector_caller<result>
+      >::dispatch(which, values, offset, visitor);
+    }
+  };
+}
+
+#endif
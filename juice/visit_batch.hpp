@@ -0,0 +1,192 @@
+/* Visitation of ranges of variants grouped by alternative.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// visit_batch visits every variant of a range. Visiting them one at a time
+// jumps to a different alternative on almost every element, which the
+// branch predictor can't follow. visit_batch first groups the elements by
+// alternative with a counting sort, and then runs one loop per alternative
+// that calls the visitor for the same type every time.
+//
+// The visitor sees the elements of one alternative in their order in the
+// range, but the alternatives one after the other. The overload with an
+// output iterator writes the result for each element at its position in the
+// range.
+
+#ifndef JUICE_VISIT_BATCH_HPP_INCLUDED
+#define JUICE_VISIT_BATCH_HPP_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "variant.hpp"
+
+namespace juice
+{
+  namespace detail
+  {
+    //The elements of a range grouped by alternative. The elements holding
+    //alternative I are m_elements[m_start[I]] to m_elements[m_start[I + 1]].
+    template <typename Variant>
+    class batch_buckets
+    {
+      public:
+      static constexpr size_t alternatives =
+        std::tuple_size<std::remove_const_t<Variant>>::value;
+
+      template <typename Iterator>
+      batch_buckets(Iterator first, Iterator last, bool positions)
+      : m_start()
+      {
+        size_t n = 0;
+        for (Iterator it = first; it != last; ++it, ++n)
+        {
+          assert(!(*it).valueless_by_exception());
+          ++m_start[(*it).index() + 1];
+        }
+
+        for (size_t i = 0; i != alternatives; ++i)
+        {
+          m_start[i + 1] += m_start[i];
+        }
+
+        m_elements.resize(n);
+        if (positions)
+        {
+          m_positions.resize(n);
+        }
+
+        std::array<size_t, alternatives> next;
+        std::copy(m_start.begin(), m_start.end() - 1, next.begin());
+
+        for (n = 0; first != last; ++first, ++n)
+        {
+          size_t k = next[(*first).index()]++;
+          m_elements[k] = std::addressof(*first);
+          if (positions)
+          {
+            m_positions[k] = n;
+          }
+        }
+      }
+
+      size_t
+      size() const
+      {
+        return m_elements.size();
+      }
+
+      template <typename Visitor, size_t... I>
+      void
+      visit(Visitor& visitor, std::index_sequence<I...>) const
+      {
+        using expand = int[];
+        (void)expand{0, (visit_alternative<I>(visitor), 0)...};
+      }
+
+      template <typename Visitor, typename OutputIterator, size_t... I>
+      void
+      visit(Visitor& visitor, OutputIterator& out,
+        std::index_sequence<I...>) const
+      {
+        using expand = int[];
+        (void)expand{0, (visit_alternative<I>(visitor, out), 0)...};
+      }
+
+      private:
+      std::array<size_t, alternatives + 1> m_start;
+      std::vector<Variant*> m_elements;
+      std::vector<size_t> m_positions;
+
+      template <size_t I, typename Visitor>
+      void
+      visit_alternative(Visitor& visitor) const
+      {
+        for (size_t k = m_start[I]; k != m_start[I + 1]; ++k)
+        {
+          visitor(get_value(variant_access::get<I>(*m_elements[k]),
+            MPL::false_()));
+        }
+      }
+
+      template <size_t I, typename Visitor, typename OutputIterator>
+      void
+      visit_alternative(Visitor& visitor, OutputIterator& out) const
+      {
+        for (size_t k = m_start[I]; k != m_start[I + 1]; ++k)
+        {
+          out[m_positions[k]] = visitor(get_value(
+            variant_access::get<I>(*m_elements[k]), MPL::false_()));
+        }
+      }
+    };
+
+    template <typename Iterator>
+    using batch_buckets_t = batch_buckets<
+      std::remove_reference_t<
+        typename std::iterator_traits<Iterator>::reference
+      >
+    >;
+  }
+
+  //Calls visitor with the alternative of every variant in [first, last),
+  //grouped by alternative. The range is walked twice, so Iterator must be
+  //a forward iterator.
+  template <typename Visitor, typename Iterator>
+  void
+  visit_batch(Visitor&& visitor, Iterator first, Iterator last)
+  {
+    typedef detail::batch_buckets_t<Iterator> buckets;
+
+    buckets(first, last, false).visit(visitor,
+      std::make_index_sequence<buckets::alternatives>());
+  }
+
+  //As above, and writes the result of visiting the n'th element to out[n],
+  //so the results are in the order of the range. Returns the end of the
+  //results.
+  template <typename Visitor, typename Iterator,
+    typename RandomAccessIterator>
+  RandomAccessIterator
+  visit_batch(Visitor&& visitor, Iterator first, Iterator last,
+    RandomAccessIterator out)
+  {
+    typedef detail::batch_buckets_t<Iterator> buckets;
+
+    buckets b(first, last, true);
+    b.visit(visitor, out, std::make_index_sequence<buckets::alternatives>());
+
+    return out + b.size();
+  }
+}
+
+#endif
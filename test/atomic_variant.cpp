@@ -0,0 +1,139 @@
+/* Tests for atomic_variant.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cassert>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <juice/atomic_variant.hpp>
+
+using namespace juice;
+
+typedef atomic_variant<std::uint32_t, float, monostate> Status;
+typedef atomic_variant<double, std::int64_t> Wide;
+
+static_assert(Status::size == 8 && Wide::size == 16,
+  "the value and its index are packed into one word");
+static_assert(Status::is_always_lock_free, "not lock free");
+
+void
+operations()
+{
+  Status s;
+  assert(get<std::uint32_t>(s.load()) == 0);
+
+  s.store(1.5f);
+  assert(get<float>(s.load()) == 1.5f);
+
+  s = monostate();
+  assert(holds_alternative<monostate>(s.load()));
+  assert(holds_alternative<monostate>(s.exchange(2.5f)));
+
+  //a failed exchange loads what was there
+  Status::value_type expected(3u);
+  assert(!s.compare_exchange_strong(expected, 4u));
+  assert(get<float>(expected) == 2.5f);
+  assert(s.compare_exchange_strong(expected, monostate()));
+
+  //equal empty alternatives compare equal whatever their padding
+  expected = monostate();
+  assert(s.compare_exchange_strong(expected, 7u));
+  assert(get<0>(s.load()) == 7);
+
+  Wide w(2.5);
+  assert(get<double>(w.exchange(std::int64_t(-1))) == 2.5);
+  Wide::value_type old(std::int64_t(-1));
+  assert(w.compare_exchange_strong(old, 0.25));
+  assert(get<double>(w.load()) == 0.25);
+}
+
+struct ToInt
+{
+  template <typename T>
+  std::int64_t
+  operator()(T t) const
+  {
+    return static_cast<std::int64_t>(t);
+  }
+};
+
+//even counts are held by the first alternative and odd counts by the
+//second, so that the index changes with every increment
+template <typename Variant>
+Variant
+counted(std::int64_t n)
+{
+  typedef std::tuple_element_t<0, Variant> Even;
+  typedef std::tuple_element_t<1, Variant> Odd;
+
+  return n % 2 == 0 ? Variant(emplaced_index_t<0>(), static_cast<Even>(n))
+    : Variant(emplaced_index_t<1>(), static_cast<Odd>(n));
+}
+
+//threads count up together with compare_exchange
+template <typename Atomic>
+void
+contention()
+{
+  typedef typename Atomic::value_type Variant;
+
+  Atomic a(counted<Variant>(0));
+  const int threads = 4;
+  const int increments = 20000;
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t != threads; ++t)
+  {
+    workers.emplace_back([&] {
+      Variant seen = a.load();
+      for (int i = 0; i != increments; ++i)
+      {
+        while (!a.compare_exchange_weak(seen,
+          counted<Variant>(visit(ToInt(), seen) + 1)))
+        {
+        }
+      }
+    });
+  }
+  for (auto& w : workers)
+  {
+    w.join();
+  }
+
+  assert(a.load() == counted<Variant>(threads * increments));
+}
+
+int main()
+{
+  operations();
+  contention<atomic_variant<std::uint32_t, std::int32_t>>();
+  contention<atomic_variant<std::int64_t, double>>();
+  return 0;
+}
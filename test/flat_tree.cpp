@@ -0,0 +1,159 @@
+/* Test file for juice::flat_tree
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cassert>
+#include <string>
+
+#include <juice/flat_tree.hpp>
+
+using namespace juice;
+
+struct Binary;
+
+typedef variant<int, std::string, recursive_wrapper<Binary>> Expression;
+
+struct Binary
+{
+  char op;
+  Expression lhs;
+  Expression rhs;
+};
+
+namespace juice
+{
+  template <>
+  struct tree_children<Binary>
+  {
+    typedef char payload_type;
+
+    static payload_type
+    payload(const Binary& b)
+    {
+      return b.op;
+    }
+
+    template <typename F>
+    static void
+    for_each(const Binary& b, F&& f)
+    {
+      f(b.lhs);
+      f(b.rhs);
+    }
+  };
+}
+
+static_assert(std::is_same<flat_tree<Expression>::value_type,
+  variant<int, std::string, char>>::value, "wrong payload");
+
+struct Evaluate
+{
+  const int* arguments;
+
+  int
+  operator()(int i) const
+  {
+    return i;
+  }
+
+  int
+  operator()(const std::string& s) const
+  {
+    return s.size();
+  }
+
+  int
+  operator()(char op) const
+  {
+    return op == '+'
+      ? arguments[0] + arguments[1]
+      : arguments[0] * arguments[1];
+  }
+};
+
+//works on both a variant and a flat_node
+template <typename Node>
+int
+evaluate(const Node& n)
+{
+  int arguments[2] = {0, 0};
+  size_t k = 0;
+  for_each_child(n, [&] (const auto& child) {
+    arguments[k++] = evaluate(child);
+  });
+
+  return visit_node(Evaluate{arguments}, n);
+}
+
+Expression
+make(char op, Expression lhs, Expression rhs)
+{
+  return Binary{op, std::move(lhs), std::move(rhs)};
+}
+
+void
+flatten()
+{
+  //(2 + "four") * (3 + 1)
+  Expression e = make('*',
+    make('+', 2, std::string("four")),
+    make('+', 3, 1));
+
+  flat_tree<Expression> flat(e);
+  assert(flat.size() == 7);
+  assert(evaluate(e) == 24);
+  assert(evaluate(flat.root()) == 24);
+
+  //the nodes are in breadth first order, with the children of a node next
+  //to each other
+  assert(get<char>(flat[0].value()) == '*');
+  assert(get<char>(flat[1].value()) == '+');
+  assert(get<char>(flat[2].value()) == '+');
+  assert(get<int>(flat[3].value()) == 2);
+  assert(get<std::string>(flat[4].value()) == "four");
+  assert(flat[2].child(1).index() == 6);
+  assert(get<int>(flat.root().child(1).child(0).value()) == 3);
+
+  //a walk over the whole tree is a scan of the nodes
+  size_t leaves = 0;
+  for (size_t i = 0; i != flat.size(); ++i)
+  {
+    leaves += flat[i].children() == 0;
+  }
+  assert(leaves == 4);
+
+  //a single leaf is a tree too
+  flat_tree<Expression> leaf(Expression(5));
+  assert(leaf.size() == 1 && evaluate(leaf.root()) == 5);
+}
+
+int main()
+{
+  flatten();
+  return 0;
+}
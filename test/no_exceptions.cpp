@@ -0,0 +1,108 @@
+/* Test of the variant headers built without exceptions
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Built with -fno-exceptions. Everything that would have thrown aborts, which
+// is checked in a child process, and try_get is the way to access a variant
+// without the risk.
+
+#include <cassert>
+#include <csignal>
+#include <cstdint>
+#include <string>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <juice/variant.hpp>
+#include <juice/variant_flat_map.hpp>
+#include <juice/variant_vector.hpp>
+
+#ifndef JUICE_NO_EXCEPTIONS
+#error "this test is built with -fno-exceptions"
+#endif
+
+using namespace juice;
+
+typedef variant<std::int64_t, recursive_wrapper<std::string>> Value;
+
+//true if f aborts in a child process
+template <typename F>
+bool
+aborts(F f)
+{
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    f();
+    _exit(0);
+  }
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+void
+access()
+{
+  Value v(std::string("text"));
+  assert(get<std::string>(v) == "text");
+
+  auto number = try_get<std::int64_t>(v);
+  assert(!number && number.error() == access_error::wrong_alternative);
+  assert(try_get<std::string>(v).value() == "text");
+
+  v = std::int64_t(3);
+  assert(get<0>(v) == 3);
+
+  assert(aborts([&] { get<std::string>(v); }));
+}
+
+void
+containers()
+{
+  typedef variant_vector<std::int64_t, std::string> Values;
+  Values values;
+  values.push_back(Values::value_type(std::int64_t(1)));
+  values.emplace_back<1>("two");
+  assert(values.size() == 2 && values[1].get<1>() == "two");
+  assert(aborts([&] { values[0].get<1>(); }));
+
+  variant_flat_map<Value, int> map;
+  map[Value(std::int64_t(1))] = 10;
+  assert(map.at(Value(std::int64_t(1))) == 10);
+  assert(aborts([&] { map.at(Value(std::int64_t(2))); }));
+}
+
+int main()
+{
+  access();
+  containers();
+  return 0;
+}
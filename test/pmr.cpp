@@ -0,0 +1,143 @@
+/* Test of recursive variants allocating from a memory_resource
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Built as C++17 for std::pmr. A tree of recursive variants is built on a
+// monotonic_buffer_resource, so that all of its nodes come from one buffer.
+
+#include <cassert>
+#include <cstddef>
+#include <memory_resource>
+
+#include <juice/variant.hpp>
+
+using namespace juice;
+
+struct Add;
+
+typedef variant<int, pmr::recursive_wrapper<Add>> Tree;
+
+struct Add
+{
+  Tree lhs;
+  Tree rhs;
+};
+
+struct Sum
+{
+  int
+  operator()(int i) const
+  {
+    return i;
+  }
+
+  int
+  operator()(const Add& a) const
+  {
+    return visit(*this, a.lhs) + visit(*this, a.rhs);
+  }
+};
+
+//a resource that counts what is allocated from it
+class counting_resource : public std::pmr::memory_resource
+{
+  public:
+  explicit counting_resource(std::pmr::memory_resource* upstream)
+  : m_upstream(upstream)
+  {
+  }
+
+  size_t allocations = 0;
+
+  private:
+  std::pmr::memory_resource* m_upstream;
+
+  void*
+  do_allocate(size_t bytes, size_t alignment) override
+  {
+    ++allocations;
+    return m_upstream->allocate(bytes, alignment);
+  }
+
+  void
+  do_deallocate(void* p, size_t bytes, size_t alignment) override
+  {
+    m_upstream->deallocate(p, bytes, alignment);
+  }
+
+  bool
+  do_is_equal(const std::pmr::memory_resource& rhs) const noexcept override
+  {
+    return this == &rhs;
+  }
+};
+
+//1 + 2 + ... + n as a chain of Adds
+Tree
+chain(int n, std::pmr::memory_resource* resource)
+{
+  std::pmr::polymorphic_allocator<Add> alloc(resource);
+  Tree tree(std::allocator_arg, alloc, 1);
+  for (int i = 2; i <= n; ++i)
+  {
+    tree = Tree(std::allocator_arg, alloc, Add{std::move(tree), Tree(i)});
+  }
+  return tree;
+}
+
+void
+monotonic()
+{
+  std::byte buffer[1 << 16];
+  counting_resource upstream(std::pmr::null_memory_resource());
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+    &upstream);
+  counting_resource counted(&arena);
+
+  {
+    Tree tree = chain(100, &counted);
+    assert(visit(Sum(), tree) == 5050);
+
+    //every node came from the arena, which never needed more memory
+    assert(counted.allocations == 99);
+    assert(upstream.allocations == 0);
+
+    //a copy given the resource allocates its root node from it, the nodes
+    //below are copied by Add, which doesn't know about the resource
+    Tree copy(std::allocator_arg,
+      std::pmr::polymorphic_allocator<Add>(&counted), tree);
+    assert(visit(Sum(), copy) == 5050);
+    assert(counted.allocations == 100);
+  }
+}
+
+int main()
+{
+  monotonic();
+  return 0;
+}
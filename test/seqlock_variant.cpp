@@ -0,0 +1,134 @@
+/* Tests for seqlock_variant.
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <juice/seqlock_variant.hpp>
+
+using namespace juice;
+
+//a value is torn when its fields differ
+struct Pair
+{
+  std::int64_t a;
+  std::int64_t b;
+};
+
+struct Quad
+{
+  std::int32_t a[4];
+};
+
+typedef seqlock_variant<Pair, Quad, monostate> Cell;
+
+struct Check
+{
+  bool
+  operator()(const Pair& p) const
+  {
+    return p.a == p.b;
+  }
+
+  bool
+  operator()(const Quad& q) const
+  {
+    return q.a[0] == q.a[1] && q.a[1] == q.a[2] && q.a[2] == q.a[3];
+  }
+
+  bool
+  operator()(monostate) const
+  {
+    return true;
+  }
+};
+
+void
+operations()
+{
+  Cell c;
+  assert(holds_alternative<Pair>(c.load()) && c.version() == 1);
+
+  c = Quad{{1, 1, 1, 1}};
+  assert(get<Quad>(c.load()).a[3] == 1 && c.version() == 2);
+
+  c.update([] (Cell::value_type& v) { v = Pair{5, 5}; });
+  assert(get<Pair>(c.load()).b == 5 && c.version() == 3);
+
+  c.store(monostate());
+  assert(holds_alternative<monostate>(c.load()));
+}
+
+//readers never see a value that is part one write and part another
+void
+torn()
+{
+  Cell c(Pair{0, 0});
+  std::atomic<bool> done(false);
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r != 3; ++r)
+  {
+    readers.emplace_back([&] {
+      while (!done.load())
+      {
+        assert(visit(Check(), c.load()));
+      }
+    });
+  }
+
+  for (std::int32_t i = 0; i != 20000; ++i)
+  {
+    if (i % 2 == 0)
+    {
+      c.store(Pair{i, i});
+    }
+    else
+    {
+      c.store(Quad{{i, i, i, i}});
+    }
+  }
+  done = true;
+
+  for (auto& r : readers)
+  {
+    r.join();
+  }
+  assert(get<Quad>(c.load()).a[0] == 19999);
+}
+
+int main()
+{
+  operations();
+  torn();
+  return 0;
+}
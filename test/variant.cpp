@@ -27,11 +27,15 @@ do so, all subject to the following:
 
 */
 
+#include <algorithm>
+#include <cassert>
+#include <functional>
 #include <iostream>
 #include <string>
 #include <memory>
 
 #include <typeinfo>
+#include <vector>
 
 #include <juice/variant.hpp>
 
@@ -148,8 +152,8 @@ foo()
   //complexa = ComplexVariant(5);
   a = MyVariant();
 
-  //auto delayed = apply_visitor(v);
-  //delayed(a);
+  auto delayed = apply_visitor(v);
+  delayed(a);
 
   Multiple m;
   visit(m, a, s);
@@ -220,9 +224,851 @@ bar()
   std::cout << "Second modify = 6: " << cint << std::endl;
 }
 
+template <size_t... I>
+juice::variant<std::integral_constant<size_t, I>...>
+make_wide(std::index_sequence<I...>);
+
+struct WhichVisitor
+{
+  template <size_t I>
+  constexpr size_t
+  operator()(std::integral_constant<size_t, I>) const
+  {
+    return I;
+  }
+};
+
+//the index only takes as much space as it needs
+static_assert(sizeof(variant<int, char>) == 2 * sizeof(int),
+  "index is not compact");
+static_assert(sizeof(variant<char, bool>) == 2, "index is not compact");
+static_assert(sizeof(variant<char, int&>) == 2 * sizeof(int*),
+  "references are stored as pointers");
+
+template <typename T>
+struct SizeOf : public std::integral_constant<size_t, sizeof(T)>
+{
+};
+
+//the metafunctions over packs
+static_assert(tuple_find<int, std::tuple<char, int, int>>::value == 1,
+  "first match");
+static_assert(tuple_find<long, std::tuple<recursive_wrapper<long>>>::value
+  == 0, "wrapped match");
+static_assert(tuple_find<long, std::tuple<char, int>>::value ==
+  tuple_not_found, "no match");
+static_assert(std::is_same<max<SizeOf, char, double, long, int>::type,
+  double>::value && max<SizeOf, char, double>::value == sizeof(double),
+  "first largest");
+static_assert(conjunction<>::value && conjunction<true, true>::value &&
+  !conjunction<true, false, true>::value, "conjunction");
+
+struct ThrowOnConstruct
+{
+  ThrowOnConstruct(int)
+  {
+    throw 1;
+  }
+
+  bool
+  operator<(const ThrowOnConstruct&) const
+  {
+    return false;
+  }
+};
+
+void
+valueless()
+{
+  //a failed emplace leaves the variant valueless, which has the index
+  //tuple_not_found even though the index is stored in a single byte
+  variant<int, ThrowOnConstruct> v(5);
+  try
+  {
+    v.emplace<1>(0);
+  }
+  catch (int)
+  {
+  }
+
+  assert(v.valueless_by_exception());
+  assert(v.index() == tuple_not_found);
+
+  //valueless is ordered before every alternative
+  decltype(v) w(-100);
+  assert(compare(v, w) < 0 && compare(w, v) > 0 && compare(v, v) == 0);
+  assert(v < w && v <= v && !(v < v));
+
+  v = 3;
+  assert(v.index() == 0);
+}
+
+void
+try_getting()
+{
+  variant<int, recursive_wrapper<std::string>> v(std::string("hello"));
+
+  auto text = try_get<std::string>(v);
+  assert(text && text->size() == 5 && text.error() == access_error::none);
+  *text += '!';
+  assert(get<1>(v) == "hello!");
+
+  auto number = try_get<0>(v);
+  assert(!number && number.error() == access_error::wrong_alternative);
+  int fallback = 3;
+  assert(&number.value_or(fallback) == &fallback);
+
+  const auto& c = v;
+  assert(try_get<1>(c).value() == "hello!");
+
+  //a reference alternative refers to what it was made from
+  int n = 4;
+  RefVariant ref(n);
+  auto referred = try_get<int&>(ref);
+  assert(referred && &referred.value() == &n);
+  *referred = 5;
+  assert(n == 5);
+
+  const RefVariant& cref = ref;
+  assert(&try_get<1>(cref).value() == &n);
+  assert(try_get<0>(cref).error() == access_error::wrong_alternative);
+
+  variant<int, ThrowOnConstruct> w(5);
+  try
+  {
+    w.emplace<1>(0);
+  }
+  catch (int)
+  {
+  }
+  assert(try_get<int>(w).error() == access_error::valueless);
+}
+
+//counts its copies, moves and live objects, copying may throw unless
+//Nothrow
+template <bool Nothrow>
+struct Counted
+{
+  static int copies;
+  static int moves;
+  static int live;
+
+  Counted() { ++live; }
+  Counted(const Counted&) noexcept(Nothrow) { ++copies; ++live; }
+  Counted(Counted&&) noexcept { ++moves; ++live; }
+  ~Counted() { --live; }
+
+  Counted& operator=(const Counted&) = default;
+  Counted& operator=(Counted&&) = default;
+};
+
+template <bool Nothrow> int Counted<Nothrow>::copies = 0;
+template <bool Nothrow> int Counted<Nothrow>::moves = 0;
+template <bool Nothrow> int Counted<Nothrow>::live = 0;
+
+template <bool Nothrow>
+void
+assign_counted()
+{
+  typedef Counted<Nothrow> C;
+  {
+    variant<int, std::string, C> a(5), b(emplaced_index_t<2>{});
+    C::copies = C::moves = 0;
+
+    //a copy that can't throw goes straight into the storage, one that can
+    //goes through a temporary
+    a = b;
+    assert(a.index() == 2);
+    assert(C::copies == 1 && C::moves == (Nothrow ? 0 : 1));
+    assert(C::live == 2);
+
+    //the same alternative is assigned into
+    a = b;
+    assert(C::copies == 1 && C::live == 2);
+
+    a = std::string("replaced");
+    assert(C::live == 1);
+    a = std::move(b);
+    assert(a.index() == 2 && C::moves == (Nothrow ? 1 : 2));
+    assert(C::live == 2);
+  }
+  assert(C::live == 0);
+}
+
+void
+assignment()
+{
+  assign_counted<true>();
+  assign_counted<false>();
+
+  //every pair of alternatives
+  typedef variant<int, std::string, std::vector<int>> V;
+  V values[] = {1, std::string("two"), std::vector<int>{3}};
+  for (const V& from : values)
+  {
+    for (const V& to : values)
+    {
+      V v(to);
+      v = from;
+      assert(v == from);
+
+      V w(to);
+      V moved(from);
+      w = std::move(moved);
+      assert(w == from);
+    }
+  }
+
+  variant<std::string, ThrowOnConstruct> empty(std::string("x"));
+  try
+  {
+    empty.emplace<1>(0);
+  }
+  catch (int)
+  {
+  }
+  assert(empty.valueless_by_exception());
+  decltype(empty) full(std::string("full"));
+  empty = full;
+  assert(get<0>(empty) == "full");
+
+  //a variant with many alternatives
+  typedef variant<std::string, std::vector<int>, char, signed char,
+    unsigned char, short, unsigned short, int, unsigned, long, unsigned long,
+    long long, unsigned long long, float, double, long double, bool> Wide;
+  Wide x(std::string("wide")), y(std::vector<int>{1, 2});
+  x = y;
+  assert(get<1>(x).size() == 2);
+  y = Wide(2.5);
+  assert(get<double>(y) == 2.5);
+  x = std::move(y);
+  assert(get<double>(x) == 2.5);
+}
+
+static_assert(is_trivially_relocatable<variant<int, std::unique_ptr<int>,
+  char&>>::value, "pointers and references are relocated as bytes");
+static_assert(!is_trivially_relocatable<variant<int, std::string>>::value,
+  "std::string may point into itself");
+
+void
+swapping()
+{
+  //variants that are relocated as bytes
+  typedef variant<int, std::unique_ptr<int>> Owner;
+  Owner a(std::unique_ptr<int>(new int(3))), b(4);
+  a.swap(b);
+  assert(get<0>(a) == 4 && *get<1>(b) == 3);
+  swap(a, b);
+  assert(*get<1>(a) == 3 && get<0>(b) == 4);
+
+  //the same alternative is swapped, others are moved
+  typedef variant<std::string, int> Text;
+  Text s(std::string("s")), t(std::string("t")), i(1);
+  s.swap(t);
+  assert(get<0>(s) == "t" && get<0>(t) == "s");
+  s.swap(i);
+  assert(get<1>(s) == 1 && get<0>(i) == "t");
+
+  int x = 1, y = 2;
+  RefVariant rx(x), ry(y);
+  swap(rx, ry);
+  assert(&get<int&>(rx) == &y && &get<int&>(ry) == &x);
+
+  Owner owners[3] = {1, std::unique_ptr<int>(new int(2)), 3};
+  alignas(Owner) unsigned char buffer[sizeof(owners)];
+  Owner* moved = reinterpret_cast<Owner*>(buffer);
+  relocate(owners, owners + 3, moved);
+  assert(get<0>(moved[0]) == 1 && *get<1>(moved[1]) == 2);
+  relocate(moved, moved + 3, owners);
+}
+
+//counts the copies of a string made by visitors
+struct CopyCounted
+{
+  static int copies;
+
+  std::string text;
+
+  CopyCounted(std::string t) : text(std::move(t)) {}
+  CopyCounted(const CopyCounted& rhs) : text(rhs.text) { ++copies; }
+  CopyCounted(CopyCounted&&) = default;
+  CopyCounted& operator=(const CopyCounted&) = default;
+  CopyCounted& operator=(CopyCounted&&) = default;
+};
+
+int CopyCounted::copies = 0;
+
+struct Length
+{
+  size_t calls = 0;
+
+  size_t
+  operator()(const CopyCounted& c)
+  {
+    ++calls;
+    return c.text.size();
+  }
+
+  size_t
+  operator()(int)
+  {
+    ++calls;
+    return 0;
+  }
+
+  size_t
+  operator()(const CopyCounted& a, const CopyCounted& b)
+  {
+    ++calls;
+    return a.text.size() + b.text.size();
+  }
+
+  template <typename A, typename B>
+  size_t
+  operator()(const A&, const B&)
+  {
+    ++calls;
+    return 0;
+  }
+};
+
+void
+delayed()
+{
+  typedef variant<int, CopyCounted> Text;
+  Text hello(CopyCounted("hello")), world(CopyCounted("world!"));
+  CopyCounted::copies = 0;
+
+  //an lvalue visitor is referred to
+  Length length;
+  auto by_reference = apply_visitor(length);
+  assert(by_reference(hello) == 5 && by_reference(hello, world) == 11);
+  assert(length.calls == 2);
+
+  //an rvalue visitor is owned, and the delayed visitors can be kept as
+  //callbacks
+  std::vector<std::function<size_t(const Text&)>> callbacks;
+  callbacks.push_back(apply_visitor(Length()));
+  callbacks.push_back(by_reference);
+  for (auto& callback : callbacks)
+  {
+    assert(callback(world) == 6);
+  }
+  assert(length.calls == 3);
+
+  //neither the variants nor their alternatives were copied
+  assert(CopyCounted::copies == 0);
+
+  const auto owner = apply_visitor(WhichVisitor());
+  assert(owner(decltype(make_wide(std::make_index_sequence<3>()))(
+    emplaced_index_t<2>())) == 2);
+}
+
+//moves the payload out of an rvalue, and copies it out of an lvalue
+struct Take
+{
+  CopyCounted
+  operator()(CopyCounted&& c) const
+  {
+    return std::move(c);
+  }
+
+  CopyCounted
+  operator()(const CopyCounted& c) const
+  {
+    return c;
+  }
+
+  CopyCounted
+  operator()(int) const
+  {
+    return CopyCounted("");
+  }
+
+  CopyCounted
+  operator()(CopyCounted&& a, CopyCounted&& b) const
+  {
+    return CopyCounted(std::move(a).text + std::move(b).text);
+  }
+
+  template <typename A, typename B>
+  CopyCounted
+  operator()(const A&, const B&) const
+  {
+    return CopyCounted("");
+  }
+};
+
+void
+forwarding()
+{
+  typedef variant<int, CopyCounted> Text;
+  typedef variant<int, recursive_wrapper<CopyCounted>> Wrapped;
+  CopyCounted::copies = 0;
+
+  //temporaries, and the alternatives in them, are moved from
+  assert(visit(Take(), Text(CopyCounted("hello"))).text == "hello");
+  assert(visit(Take(), Wrapped(CopyCounted("wrapped"))).text == "wrapped");
+  assert(visit_likely<CopyCounted>(Take(), Text(CopyCounted("likely")))
+    .text == "likely");
+
+  Text hello(CopyCounted("hello")), world(CopyCounted("world"));
+  assert(visit(Take(), std::move(hello), std::move(world)).text ==
+    "helloworld");
+  assert(CopyCounted::copies == 0);
+
+  //as are the arguments after the variants
+  Text one(1);
+  auto moved = [] (const auto&, CopyCounted&& c) {
+    return CopyCounted(std::move(c));
+  };
+  assert(visit(moved, one, CopyCounted("extra")).text == "extra");
+  assert(CopyCounted::copies == 0);
+
+  //an lvalue is still copied from
+  Text kept(CopyCounted("kept"));
+  assert(visit(Take(), kept).text == "kept");
+  assert(get<CopyCounted>(kept).text == "kept");
+  assert(CopyCounted::copies == 1);
+}
+
+enum class Colour : unsigned char
+{
+  red,
+  green,
+  blue
+};
+
+namespace juice
+{
+  template <>
+  struct niche_traits<Colour>
+    : public enum_niche_traits<Colour, Colour::red, Colour::blue>
+  {
+  };
+}
+
+struct Empty {};
+
+//the index is hidden in spare bit patterns of the only non-empty type
+static_assert(sizeof(variant<monostate, int*>) == sizeof(int*),
+  "pointer niche not used");
+static_assert(sizeof(variant<bool, monostate, Empty>) == 1,
+  "bool niche not used");
+static_assert(sizeof(variant<Empty, Colour>) == 1, "enum niche not used");
+static_assert(sizeof(variant<monostate, int&>) == sizeof(int*),
+  "ref niche not used");
+
+void
+niche()
+{
+  int n = 0;
+  variant<monostate, int*> p;
+  assert(p.index() == 0);
+  p = &n;
+  assert(p.index() == 1 && get<1>(p) == &n);
+  p = static_cast<int*>(nullptr);
+  assert(p.index() == 1 && get<1>(p) == nullptr);
+  p = monostate();
+  assert(p.index() == 0);
+
+  variant<bool, monostate, Empty> b(false);
+  assert(b.index() == 0 && !get<0>(b));
+  b = Empty();
+  assert(b.index() == 2);
+  b = true;
+  assert(b.index() == 0 && get<0>(b));
+
+  variant<Empty, Colour> c(Colour::blue);
+  assert(c.index() == 1 && get<1>(c) == Colour::blue);
+  c.emplace<0>();
+  assert(c.index() == 0);
+
+  variant<monostate, int&> r(n);
+  assert(r.index() == 1);
+  r = monostate();
+  assert(r.index() == 0);
+}
+
+//the special members are trivial exactly when those of the types are
+static_assert(std::is_trivially_copyable<variant<int, double, float>>::value,
+  "variant of trivial types is not trivially copyable");
+static_assert(std::is_trivially_destructible<variant<int, char>>::value,
+  "variant of trivial types is not trivially destructible");
+static_assert(!std::is_trivially_copyable<MyVariant>::value,
+  "variant of a string is trivially copyable");
+static_assert(std::is_trivially_destructible<RefVariant>::value,
+  "variant of references is not trivially destructible");
+static_assert(std::is_nothrow_move_constructible<MyVariant>::value,
+  "variant move constructor is not noexcept");
+
+void
+special_members()
+{
+  variant<int, double, float> a(2.5), b(1);
+  b = a;
+  assert(b.index() == 1 && get<double>(b) == 2.5);
+
+  MyVariant s(std::string("copy")), t(s);
+  assert(get<std::string>(t) == "copy");
+  t = MyVariant(3);
+  assert(get<int>(t) == 3);
+  t = s;
+  assert(get<std::string>(t) == "copy");
+
+  //references are rebound rather than assigned through
+  int x = 1, y = 2;
+  RefVariant rx(x), ry(y);
+  rx = ry;
+  get<int&>(rx) = 3;
+  assert(x == 1 && y == 3);
+}
+
+struct Opcode
+{
+  constexpr int
+  operator()(int i) const
+  {
+    return i;
+  }
+
+  constexpr int
+  operator()(char c) const
+  {
+    return -c;
+  }
+};
+
+//tables of variants can be built at compile time
+constexpr variant<int, char> opcodes[] = {1, 'a', {}};
+
+static_assert(opcodes[0].index() == 0 && get<0>(opcodes[0]) == 1,
+  "constexpr construction");
+static_assert(get<char>(opcodes[1]) == 'a', "constexpr get");
+static_assert(get_if<0>(&opcodes[1]) == nullptr &&
+  *get_if<1>(&opcodes[1]) == 'a', "constexpr get_if");
+static_assert(holds_alternative<int>(opcodes[2]) && get<0>(opcodes[2]) == 0,
+  "constexpr default construction");
+static_assert(visit(Opcode(), opcodes[0]) == 1 &&
+  visit(Opcode(), opcodes[1]) == -'a', "constexpr visit");
+static_assert(opcodes[0] == variant<int, char>(1) &&
+  !(opcodes[0] == opcodes[1]), "constexpr equality");
+static_assert(opcodes[2] < opcodes[0] && opcodes[0] < opcodes[1] &&
+  opcodes[1] >= opcodes[1], "constexpr ordering");
+
+//a wide variant is visited through a table in constant expressions too
+constexpr decltype(make_wide(std::make_index_sequence<40>()))
+  wide_opcode(emplaced_index<33>);
+static_assert(visit(WhichVisitor(), wide_opcode) == 33,
+  "constexpr table visit");
+static_assert(visit_likely<std::integral_constant<size_t, 33>>(
+  WhichVisitor(), wide_opcode) == 33, "constexpr likely visit");
+
+typedef decltype(make_wide(std::make_index_sequence<12>())) Hinted;
+
+namespace juice
+{
+  template <>
+  struct dispatch_hint<Hinted>
+  {
+    typedef likely<std::integral_constant<size_t, 7>,
+      std::integral_constant<size_t, 2>> type;
+  };
+}
+
+void
+dispatch()
+{
+  //small variants dispatch through a switch, wide ones through a table
+  typedef decltype(make_wide(std::make_index_sequence<8>())) Narrow;
+  typedef decltype(make_wide(std::make_index_sequence<40>())) Wide;
+
+  Narrow narrow(emplaced_index_t<5>{});
+  assert(visit(WhichVisitor(), narrow) == 5);
+
+  Wide wide(emplaced_index_t<37>{});
+  assert(visit(WhichVisitor(), wide) == 37);
+  wide = std::integral_constant<size_t, 2>();
+  assert(visit(WhichVisitor(), wide) == 2);
+  assert(wide.index() == 2);
+  assert(!wide.valueless_by_exception());
+
+  //the likely alternatives are checked first, the rest still dispatch
+  typedef std::integral_constant<size_t, 1> One;
+  typedef std::integral_constant<size_t, 2> Two;
+  typedef std::integral_constant<size_t, 5> Five;
+  assert(visit_likely<Two>(WhichVisitor(), wide) == 2);
+  assert(visit_likely<Five>(WhichVisitor(), narrow) == 5);
+  assert(visit_likely<One>(WhichVisitor(), narrow) == 5);
+
+  //visit uses the dispatch_hint of the variant
+  Hinted hinted(emplaced_index_t<7>{});
+  assert(visit(WhichVisitor(), hinted) == 7);
+  hinted = Two();
+  assert(visit(WhichVisitor(), hinted) == 2);
+  hinted = std::integral_constant<size_t, 11>();
+  assert(visit(WhichVisitor(), hinted) == 11);
+}
+
+struct Combine
+{
+  int
+  operator()(int a, char b, double c, int scale) const
+  {
+    return (a + b + static_cast<int>(c)) * scale;
+  }
+
+  template <typename A, typename B, typename C>
+  int
+  operator()(const A&, const B&, const C&, int) const
+  {
+    return -1;
+  }
+};
+
+struct Increment
+{
+  void
+  operator()(char&) const
+  {
+  }
+
+  void
+  operator()(int& i) const
+  {
+    ++i;
+  }
+};
+
+void
+multi()
+{
+  //three variants and an extra argument go through one dispatch
+  variant<std::string, int> a(1);
+  variant<char, std::string> b('\x02');
+  const variant<std::string, double, int> c(3.0);
+
+  assert(visit(Combine(), a, b, c, 10) == 60);
+
+  b = std::string("two");
+  assert(visit(Combine(), a, b, c, 10) == -1);
+
+  //reference alternatives are visited as the referenced object
+  int n = 1;
+  RefVariant r(n);
+  visit(Increment(), r);
+  assert(n == 2);
+}
+
+//counts the allocations that are alive
+template <typename T>
+struct CountingAllocator
+{
+  typedef T value_type;
+
+  CountingAllocator(int* count)
+  : count(count)
+  {
+  }
+
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>& rhs)
+  : count(rhs.count)
+  {
+  }
+
+  T*
+  allocate(size_t n)
+  {
+    ++*count;
+    return std::allocator<T>().allocate(n);
+  }
+
+  void
+  deallocate(T* p, size_t n)
+  {
+    --*count;
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  int* count;
+};
+
+template <typename T, typename U>
+bool
+operator==(const CountingAllocator<T>& a, const CountingAllocator<U>& b)
+{
+  return a.count == b.count;
+}
+
+template <typename T, typename U>
+bool
+operator!=(const CountingAllocator<T>& a, const CountingAllocator<U>& b)
+{
+  return !(a == b);
+}
+
+struct Binary;
+
+typedef variant<int, recursive_wrapper<Binary, CountingAllocator<Binary>>>
+  Expression;
+
+struct Binary
+{
+  Expression lhs;
+  Expression rhs;
+};
+
+static_assert(std::uses_allocator<Expression, CountingAllocator<char>>::value,
+  "variant does not use allocators");
+
+void
+allocator()
+{
+  int live = 0;
+  CountingAllocator<char> alloc(&live);
+
+  {
+    //the allocator is passed on to the recursive_wrapper
+    Expression e(std::allocator_arg, alloc, Binary{Expression(1),
+      Expression(2)});
+    assert(live == 1);
+    assert(get<int>(get<Binary>(e).rhs) == 2);
+
+    Expression copy(std::allocator_arg, alloc, e);
+    assert(live == 2);
+    assert(get<int>(get<Binary>(copy).lhs) == 1);
+
+    //equal allocators hand over the node without allocating
+    Expression moved(std::allocator_arg, alloc, std::move(copy));
+    assert(live == 2);
+
+    Expression leaf(std::allocator_arg, alloc, emplaced_index<0>, 3);
+    assert(get<0>(leaf) == 3 && live == 2);
+  }
+
+  assert(live == 0);
+
+  //a moved from wrapper has no node, which unequal allocators must not
+  //copy from or assign to
+  {
+    typedef recursive_wrapper<std::string, CountingAllocator<std::string>>
+      Node;
+    int other = 0;
+    Node a(std::allocator_arg, &live, std::string("a"));
+    Node b(std::move(a));
+    Node c(std::allocator_arg, &other, std::string("c"));
+
+    a = std::move(c);
+    assert(a.get() == "c" && live == 2 && other == 1);
+
+    Node empty(std::move(b));
+    Node d(std::allocator_arg, &other, std::move(b));
+    assert(live == 2 && other == 1);
+
+    d = std::move(c);
+    Node e(std::allocator_arg, &other, std::string("e"));
+    e = std::move(b);
+    assert(live == 2 && other == 1);
+    e = std::move(empty);
+    assert(e.get() == "a" && live == 2 && other == 2);
+  }
+
+  assert(live == 0);
+
+  //the default is still std::allocator
+  typedef variant<int, recursive_wrapper<std::string>> Wrapped;
+  Wrapped w(std::string("heap"));
+  Wrapped v(w);
+  assert(get<std::string>(v) == "heap");
+}
+
+struct Cons;
+
+typedef variant<monostate, recursive_wrapper<Cons>> List;
+
+struct Cons
+{
+  int head;
+  List tail;
+};
+
+void
+teardown()
+{
+  //destroying this by recursion would overflow the stack
+  List list;
+  for (int i = 0; i != 1000000; ++i)
+  {
+    List next(Cons{i, std::move(list)});
+    list = std::move(next);
+  }
+  assert(get<Cons>(list).head == 999999);
+  assert(get<Cons>(get<Cons>(list).tail).head == 999998);
+
+  list = monostate();
+  assert(list.index() == 0);
+}
+
+void
+comparison()
+{
+  typedef variant<int, std::string> V;
+  V one(1), two(2), a(std::string("a")), b(std::string("b"));
+
+  //by index first, then by value
+  assert(compare(one, two) < 0 && compare(two, one) > 0);
+  assert(compare(one, V(1)) == 0);
+  assert(compare(two, a) < 0 && compare(b, one) > 0);
+  assert(compare(a, b) < 0);
+
+  assert(one < two && !(two < one) && two > one);
+  assert(one <= two && one <= V(1) && !(two <= one));
+  assert(two >= one && one >= V(1) && !(one >= two));
+  assert(one != two && !(one != V(1)));
+
+  std::vector<V> keys{b, two, a, one};
+  std::sort(keys.begin(), keys.end());
+  assert((keys == std::vector<V>{one, two, a, b}));
+}
+
+void
+hashing()
+{
+  typedef variant<int, long, std::string> V;
+  std::hash<V> h;
+
+  //equal values of different alternatives hash differently
+  assert(h(V(5)) == h(V(5)));
+  assert(h(V(5)) != h(V(5L)));
+  assert(h(V(std::string("a"))) != h(V(std::string("b"))));
+
+  V values[] = {1, 2L, std::string("three"), 4, 5L};
+  size_t hashes[5];
+  hash_batch(std::begin(values), std::end(values), hashes);
+  for (size_t i = 0; i != 5; ++i)
+  {
+    assert(hashes[i] == h(values[i]));
+  }
+}
+
 int main(int argc, char** argv)
 {
   foo();
   bar();
+  dispatch();
+  valueless();
+  try_getting();
+  niche();
+  special_members();
+  multi();
+  allocator();
+  teardown();
+  assignment();
+  swapping();
+  delayed();
+  forwarding();
+  comparison();
+  hashing();
   return 0;
 }
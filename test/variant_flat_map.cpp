@@ -0,0 +1,202 @@
+/* Test file for juice::variant_flat_map
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <juice/variant_flat_map.hpp>
+
+using namespace juice;
+
+typedef variant<std::int64_t, std::string> Key;
+
+void
+lookup()
+{
+  variant_flat_map<Key, int> map;
+  assert(map.empty() && map.find(Key(1L)) == map.end());
+
+  assert(map.try_emplace(Key(std::int64_t(1)), 10).second);
+  assert(map.insert({Key(std::string("one")), 11}).second);
+  map[Key(std::int64_t(2))] = 20;
+  assert(!map.try_emplace(Key(std::int64_t(1)), 99).second);
+  assert(map.size() == 3);
+
+  assert(map.at(Key(std::int64_t(1))) == 10);
+  assert(map[Key(std::string("one"))] == 11);
+
+  //by a bare alternative, the 1 of one alternative isn't the other's
+  assert(map.find(std::int64_t(2))->second == 20);
+  assert(map.count(std::string("one")) == 1);
+  assert(map.count(std::string("two")) == 0);
+  assert(map.count(std::int64_t(3)) == 0);
+
+  bool thrown = false;
+  try
+  {
+    map.at(std::int64_t(3));
+  }
+  catch (const std::out_of_range&)
+  {
+    thrown = true;
+  }
+  assert(thrown);
+
+  int sum = 0;
+  for (const auto& element : map)
+  {
+    sum += element.second;
+  }
+  assert(sum == 41);
+
+  assert(map.erase(std::string("one")) == 1);
+  assert(map.erase(std::string("one")) == 0);
+  assert(map.size() == 2 && map.count(std::string("one")) == 0);
+
+  const auto copy = map;
+  map.clear();
+  assert(map.empty() && copy.size() == 2);
+  assert(copy.find(Key(std::int64_t(2)))->second == 20);
+}
+
+//against std::unordered_map through growth and many erasures
+void
+churn()
+{
+  variant_flat_map<Key, std::int64_t> map;
+  std::unordered_map<std::int64_t, std::int64_t> numbers;
+  std::unordered_map<std::string, std::int64_t> strings;
+
+  for (std::int64_t i = 0; i != 20000; ++i)
+  {
+    std::int64_t k = (i * 7919) % 5000;
+    if (i % 3 == 0)
+    {
+      assert(map.erase(k) == numbers.erase(k));
+    }
+    else if (i % 3 == 1)
+    {
+      map[Key(k)] = i;
+      numbers[k] = i;
+    }
+    else
+    {
+      map[Key(std::to_string(k))] = i;
+      strings[std::to_string(k)] = i;
+    }
+  }
+
+  assert(map.size() == numbers.size() + strings.size());
+  for (const auto& n : numbers)
+  {
+    assert(map.at(n.first) == n.second);
+  }
+  for (const auto& s : strings)
+  {
+    assert(map.at(s.first) == s.second);
+  }
+
+  for (const auto& element : map)
+  {
+    if (element.first.index() == 0)
+    {
+      assert(numbers.count(get<std::int64_t>(element.first)) == 1);
+    }
+  }
+}
+
+//elements that are trivially relocatable are moved as bytes
+void
+relocation()
+{
+  typedef variant<std::int64_t, double> Number;
+  static_assert(is_trivially_relocatable<
+    std::pair<const Number, std::unique_ptr<int>>>::value,
+    "the elements are not trivially relocatable");
+
+  variant_flat_map<Number, std::unique_ptr<int>> map;
+  for (int i = 0; i != 1000; ++i)
+  {
+    map.try_emplace(Number(std::int64_t(i)), new int(i));
+    map.try_emplace(Number(i + 0.5), new int(-i));
+  }
+  for (int i = 0; i < 1000; i += 2)
+  {
+    assert(map.erase(Number(std::int64_t(i))) == 1);
+  }
+
+  assert(map.size() == 1500);
+  for (int i = 0; i != 1000; ++i)
+  {
+    assert(*map.at(Number(i + 0.5)) == -i);
+    assert(map.count(Number(std::int64_t(i))) == (i % 2 == 1 ? 1 : 0));
+  }
+}
+
+//a lookup that finds the key doesn't grow a full map
+void
+stable_hits()
+{
+  variant_flat_map<Key, int> map;
+
+  //twelve is the most that sixteen slots hold
+  for (std::int64_t i = 0; i != 12; ++i)
+  {
+    map[Key(i)] = static_cast<int>(i);
+  }
+
+  int& zero = map.find(Key(std::int64_t(0)))->second;
+  auto first = map.begin();
+  const Key* key = &first->first;
+
+  map[Key(std::int64_t(1))] = map[Key(std::int64_t(2))];
+  assert(!map.try_emplace(Key(std::int64_t(3)), 30).second);
+  assert(!map.insert({Key(std::int64_t(4)), 40}).second);
+
+  assert(map.size() == 12);
+  assert(&map[Key(std::int64_t(0))] == &zero);
+  assert(map.begin() == first && &map.begin()->first == key);
+  assert(map.at(Key(std::int64_t(1))) == 2);
+
+  //an insertion still grows it
+  map[Key(std::int64_t(12))] = 12;
+  assert(map.size() == 13 && map.at(Key(std::int64_t(0))) == 0);
+}
+
+int main()
+{
+  lookup();
+  churn();
+  relocation();
+  stable_hits();
+  return 0;
+}
@@ -0,0 +1,193 @@
+/* Test file for the variant profile counters
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+#define JUICE_VARIANT_PROFILE
+
+#include <cassert>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <juice/variant.hpp>
+#include <juice/variant_vector.hpp>
+
+using namespace juice;
+
+typedef variant<int, std::string> V;
+
+struct Ignore
+{
+  template <typename... T>
+  void
+  operator()(const T&...) const
+  {
+  }
+};
+
+const profile::entry&
+find(const std::vector<profile::entry>& entries, size_t index)
+{
+  for (const profile::entry& e : entries)
+  {
+    if (e.variant.find("std::") != std::string::npos && e.index == index)
+    {
+      return e;
+    }
+  }
+  assert(false);
+  return entries.front();
+}
+
+void
+counts()
+{
+  V a(1);
+  V b(std::string("two"));
+  V c(a);
+  V d(std::move(b));
+  c = d;
+  c = 5;
+  d.emplace<0>(3);
+
+  visit(Ignore(), a);
+  visit(Ignore(), c);
+  visit(Ignore(), a, b);
+
+  try
+  {
+    get<std::string>(a);
+  }
+  catch (const bad_variant_access&)
+  {
+  }
+
+  //another thread's counts are merged when it exits
+  std::thread([] {
+    V e(std::string("thread"));
+    visit(Ignore(), e);
+  }).join();
+
+  auto entries = profile::snapshot();
+  const profile::entry& i = find(entries, 0);
+  const profile::entry& s = find(entries, 1);
+
+  assert(i.alternative == "int");
+  assert(i.counts[profile::construction] == 3);
+  assert(i.counts[profile::assignment] == 1);
+  assert(i.counts[profile::visit] == 3);
+  assert(i.counts[profile::bad_access] == 0);
+
+  assert(s.counts[profile::construction] == 3);
+  assert(s.counts[profile::assignment] == 1);
+  assert(s.counts[profile::visit] == 2);
+  assert(s.counts[profile::bad_access] == 1);
+
+  std::ostringstream out;
+  profile::report(out);
+  assert(out.str().find("juice::variant<int") != std::string::npos);
+}
+
+//uses-allocator copies and moves count the alternative that they construct
+void
+allocated()
+{
+  typedef variant<double, std::string> A;
+  A a(std::string("one"));
+  A b(std::allocator_arg, std::allocator<char>(), a);
+  A c(std::allocator_arg, std::allocator<char>(), std::move(b));
+
+  size_t constructed[2] = {};
+  for (const profile::entry& e : profile::snapshot())
+  {
+    if (e.variant.find("variant<double") != std::string::npos &&
+      e.index < 2)
+    {
+      constructed[e.index] = e.counts[profile::construction];
+    }
+  }
+
+  assert(constructed[0] == 0);
+  assert(constructed[1] == 3);
+}
+
+//a wrong alternative of an element of a variant_vector is a bad access of
+//its variant
+void
+vector_access()
+{
+  variant_vector<long, std::string> values;
+  values.emplace_back<long>(1);
+  try
+  {
+    values[0].get<std::string>();
+  }
+  catch (const bad_variant_access&)
+  {
+  }
+
+  std::uint64_t bad = 0;
+  for (const profile::entry& e : profile::snapshot())
+  {
+    if (e.variant.find("variant<long") != std::string::npos && e.index == 1)
+    {
+      bad = e.counts[profile::bad_access];
+    }
+  }
+  assert(bad == 1);
+}
+
+//run after counts, which visits int three times and std::string twice
+void
+hints()
+{
+  std::ostringstream all;
+  profile::write_hints(all);
+  assert(all.str().find("struct dispatch_hint<juice::variant<int, std::")
+    != std::string::npos);
+  assert(all.str().find("typedef likely<int, std::") != std::string::npos);
+
+  std::ostringstream most;
+  profile::write_hints(most, 0.5);
+  assert(most.str().find("typedef likely<int>") != std::string::npos);
+
+  std::ostringstream one;
+  profile::write_hints(one, 0, 1);
+  assert(one.str().find("typedef likely<int>") != std::string::npos);
+}
+
+int main()
+{
+  profile::report_at_exit(false);
+  counts();
+  allocated();
+  vector_access();
+  hints();
+  return 0;
+}
@@ -0,0 +1,167 @@
+/* Test file for juice::variant_vector
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cassert>
+#include <string>
+
+#include <juice/variant_vector.hpp>
+
+using namespace juice;
+
+typedef variant<int, std::string, double> Event;
+
+struct Describe
+{
+  std::string
+  operator()(int i) const
+  {
+    return "int " + std::to_string(i);
+  }
+
+  std::string
+  operator()(const std::string& s) const
+  {
+    return "string " + s;
+  }
+
+  std::string
+  operator()(double) const
+  {
+    return "double";
+  }
+};
+
+struct Double
+{
+  template <typename T>
+  void
+  operator()(T& t) const
+  {
+    t = t + t;
+  }
+};
+
+void
+store()
+{
+  variant_vector<int, std::string, double> events;
+  assert(events.empty());
+
+  events.push_back(Event(1));
+  events.push_back(Event(std::string("two")));
+  Event three(3);
+  events.push_back(three);
+  events.emplace_back<double>(4.5);
+  events.emplace_back<1>(2, 'x');
+
+  assert(events.size() == 5);
+  assert(events[0].index() == 0 && events[1].index() == 1);
+  assert(events[3].holds_alternative<double>());
+  assert(events[4].get<std::string>() == "xx");
+
+  //each alternative is contiguous, in the order it was added
+  assert((events.alternatives<int>() == std::vector<int>{1, 3}));
+  assert(events.alternatives<1>().size() == 2);
+  assert(events.alternatives<double>().front() == 4.5);
+
+  assert(events[1].visit(Describe()) == "string two");
+  assert(events[2].visit(Describe()) == "int 3");
+
+  //values can be modified in place
+  events[0].get<0>() = 10;
+  events[1].visit(Double());
+  assert(events[0].get<int>() == 10);
+  assert(events[1].get<std::string>() == "twotwo");
+
+  bool thrown = false;
+  try
+  {
+    events[0].get<double>();
+  }
+  catch (const bad_variant_access&)
+  {
+    thrown = true;
+  }
+  assert(thrown);
+
+  //an element can be copied out as a variant
+  Event e = events[3].value();
+  assert(get<double>(e) == 4.5);
+
+  std::string all;
+  for (auto element : events)
+  {
+    all += element.visit(Describe()) + ";";
+  }
+  assert(all == "int 10;string twotwo;int 3;double;string xx;");
+
+  const auto& cevents = events;
+  auto it = cevents.begin() + 2;
+  assert(cevents.end() - it == 3);
+  assert(it[1].get<double>() == 4.5);
+  assert((*--it).index() == 1);
+
+  events.pop_back();
+  events.pop_back();
+  assert(events.size() == 3);
+  assert(events.alternatives<std::string>().size() == 1);
+  assert(events.alternatives<double>().empty());
+
+  events.clear();
+  assert(events.empty() && events.alternatives<int>().empty());
+}
+
+//bools have references like every other alternative
+void
+flags()
+{
+  typedef variant<int, bool> Flag;
+  variant_vector<int, bool> flags;
+  flags.emplace_back<bool>(true);
+  flags.push_back(Flag(false));
+  flags.emplace_back<int>(7);
+
+  bool& first = flags[0].get<bool>();
+  first = false;
+  flags[1].get<1>() = true;
+  flags[1].visit(Double());
+
+  assert(!flags[0].get<bool>() && flags[1].get<bool>());
+  assert(get<bool>(flags[1].value()));
+  assert(flags.alternatives<bool>().size() == 2 &&
+    flags.alternatives<bool>().back());
+  assert(flags[2].get<int>() == 7);
+}
+
+int main()
+{
+  store();
+  flags();
+  return 0;
+}
@@ -0,0 +1,128 @@
+/* Test file for juice::visit_batch
+   Copyright (C) 2016 Jarryd Beck
+
+Distributed under the Boost Software License, Version 1.0
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+  The copyright notices in the Software and this entire statement, including
+  the above license grant, this restriction and the following disclaimer,
+  must be included in all copies of the Software, in whole or in part, and
+  all derivative works of the Software, unless such copies or derivative
+  works are solely in the form of machine-executable object code generated by
+  a source language processor.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cassert>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <juice/visit_batch.hpp>
+
+using namespace juice;
+
+struct Order;
+
+typedef variant<int, std::string, recursive_wrapper<Order>> Message;
+
+struct Order
+{
+  int quantity;
+};
+
+//records the order in which it is called
+struct Record
+{
+  std::string* log;
+
+  int
+  operator()(int i) const
+  {
+    *log += "i";
+    return i;
+  }
+
+  int
+  operator()(const std::string& s) const
+  {
+    *log += "s";
+    return s.size();
+  }
+
+  int
+  operator()(const Order& o) const
+  {
+    *log += "o";
+    return o.quantity * 10;
+  }
+};
+
+struct Increment
+{
+  void operator()(int& i) const { ++i; }
+  void operator()(std::string& s) const { s += "!"; }
+  void operator()(Order& o) const { ++o.quantity; }
+};
+
+void
+batch()
+{
+  std::vector<Message> messages{
+    1, std::string("ab"), Order{3}, 2, std::string("c"), 4, Order{5}
+  };
+
+  //grouped by alternative, each group in the order of the range
+  std::string log;
+  std::vector<int> unordered;
+  visit_batch([&] (const auto& x) {
+    unordered.push_back(Record{&log}(x));
+  }, messages.begin(), messages.end());
+  assert(log == "iiissoo");
+  assert((unordered == std::vector<int>{1, 2, 4, 2, 1, 30, 50}));
+
+  //the results in the order of the range
+  log.clear();
+  std::vector<int> results(messages.size());
+  auto end = visit_batch(Record{&log}, messages.cbegin(), messages.cend(),
+    results.begin());
+  assert(end == results.end());
+  assert(log == "iiissoo");
+  assert((results == std::vector<int>{1, 2, 30, 2, 1, 4, 50}));
+
+  //the elements can be modified
+  visit_batch(Increment(), messages.begin(), messages.end());
+  assert(get<int>(messages[0]) == 2);
+  assert(get<std::string>(messages[1]) == "ab!");
+  assert(get<Order>(messages[6]).quantity == 6);
+
+  //any forward iterator will do
+  std::list<Message> list(messages.begin(), messages.end());
+  log.clear();
+  visit_batch(Record{&log}, list.begin(), list.end());
+  assert(log == "iiissoo");
+
+  //an empty range
+  visit_batch(Record{&log}, list.end(), list.end());
+  assert(log.size() == 7);
+}
+
+int main()
+{
+  batch();
+  return 0;
+}